@@ -0,0 +1,71 @@
+/* benchrun.c: time a command for the benchmark driver.
+
+   usage: benchrun RUNS LOGFILE COMMAND [ARG...]
+
+   Runs COMMAND RUNS times with stdin from /dev/null and stdout/stderr
+   appended to LOGFILE, and prints `SECONDS KILOBYTES': the fastest
+   wall-clock time and the largest resident set size seen.  The exit
+   status is that of the last run.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static double
+now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+  int runs, k, status = 0, fd;
+  double best = -1.0, start, t;
+  long maxrss = 0;
+  struct rusage ru;
+  pid_t pid;
+
+  if (argc < 4 || (runs = atoi (argv[1])) < 1) {
+    fprintf (stderr, "usage: benchrun RUNS LOGFILE COMMAND [ARG...]\n");
+    return 2;
+  }
+  for (k = 0; k < runs; k++) {
+    start = now ();
+    pid = fork ();
+    if (pid < 0) {
+      perror ("benchrun: fork");
+      return 2;
+    }
+    if (pid == 0) {
+      if ((fd = open ("/dev/null", O_RDONLY)) >= 0)
+        dup2 (fd, 0);
+      if ((fd = open (argv[2], O_WRONLY | O_CREAT | O_APPEND, 0666)) >= 0) {
+        dup2 (fd, 1);
+        dup2 (fd, 2);
+      }
+      execvp (argv[3], argv + 3);
+      perror (argv[3]);
+      _exit (127);
+    }
+    if (wait4 (pid, &status, 0, &ru) < 0) {
+      perror ("benchrun: wait4");
+      return 2;
+    }
+    t = now () - start;
+    if (best < 0 || t < best)
+      best = t;
+    if (ru.ru_maxrss > maxrss)
+      maxrss = ru.ru_maxrss;
+  }
+  printf ("%.3f %ld\n", best, maxrss);
+  return WIFEXITED (status) ? WEXITSTATUS (status) : 2;
+}
@@ -0,0 +1,153 @@
+/* mktfm.c: write the synthetic TFM files used by the benchmark corpus.
+
+   The benchmark must run without a TeX distribution, so its fonts are
+   made up: printable ASCII with a handful of plausible widths, heights
+   and depths, and the parameters that TeX insists on for text fonts
+   (7), math symbol fonts (22) and math extension fonts (13).
+
+   usage: mktfm text|symbol|extension FILE.tfm [EXPANSION]
+
+   EXPANSION (in thousandths) widens or narrows every character, which
+   gives the `NAME+20.tfm' style instances needed by \pdffontexpand.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BC 32
+#define EC 126
+#define FIX(x) ((long)((x) * 1048576.0 + 0.5)) /* design-size units */
+
+static const double widths[] = { 0.0, 0.278, 0.5, 0.667, 0.833, 0.333 };
+static const double heights[] = { 0.0, 0.431, 0.683, 0.75 };
+static const double depths[] = { 0.0, 0.194, 0.25 };
+
+#define NW (sizeof (widths) / sizeof (widths[0]))
+#define NH (sizeof (heights) / sizeof (heights[0]))
+#define ND (sizeof (depths) / sizeof (depths[0]))
+
+static FILE *tfm;
+
+static void
+put_word (long w)
+{
+  putc ((w >> 24) & 0xff, tfm);
+  putc ((w >> 16) & 0xff, tfm);
+  putc ((w >> 8) & 0xff, tfm);
+  putc (w & 0xff, tfm);
+}
+
+static void
+put_halves (int a, int b)
+{
+  put_word (((long) a << 16) | b);
+}
+
+static int
+width_of (int c)
+{
+  if (strchr (" il.,;:!'|`()[]", c))
+    return 1;
+  if (strchr ("mwMW@%", c))
+    return 4;
+  if (strchr ("ftrj-", c))
+    return 5;
+  if (c >= 'A' && c <= 'Z')
+    return 3;
+  return 2;
+}
+
+static int
+height_of (int c)
+{
+  if (c == ' ')
+    return 0;
+  if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || strchr ("bdfhklt", c))
+    return 2;
+  if (strchr ("()[]{}/|", c))
+    return 3;
+  return 1;
+}
+
+static int
+depth_of (int c)
+{
+  if (strchr ("gjpqy,;", c))
+    return 1;
+  if (strchr ("()[]{}/|", c))
+    return 2;
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  double scale = 1.0;
+  long params[23];
+  int np, lh = 2, c, k;
+
+  if (argc < 3 || argc > 4) {
+    fprintf (stderr, "usage: mktfm text|symbol|extension FILE.tfm [EXPANSION]\n");
+    return 1;
+  }
+  memset (params, 0, sizeof (params));
+  params[2] = FIX (0.333);  /* space */
+  params[3] = FIX (0.167);  /* space stretch */
+  params[4] = FIX (0.111);  /* space shrink */
+  params[5] = FIX (0.431);  /* x-height */
+  params[6] = FIX (1.0);    /* quad */
+  params[7] = FIX (0.111);  /* extra space */
+  if (strcmp (argv[1], "text") == 0) {
+    np = 7;
+  } else if (strcmp (argv[1], "symbol") == 0) {
+    np = 22;
+    for (k = 8; k <= 22; k++)
+      params[k] = FIX (0.1 + 0.02 * k); /* num1 ... axis_height */
+    params[22] = FIX (0.25);
+  } else if (strcmp (argv[1], "extension") == 0) {
+    np = 13;
+    params[8] = FIX (0.04);  /* default rule thickness */
+    for (k = 9; k <= 13; k++)
+      params[k] = FIX (0.1); /* big op spacing */
+  } else {
+    fprintf (stderr, "mktfm: unknown font kind `%s'\n", argv[1]);
+    return 1;
+  }
+  if (argc == 4)
+    scale = (1000.0 + atoi (argv[3])) / 1000.0;
+  if ((tfm = fopen (argv[2], "wb")) == NULL) {
+    perror (argv[2]);
+    return 1;
+  }
+
+  /* lf lh bc ec nw nh nd ni nl nk ne np */
+  put_halves (6 + lh + (EC - BC + 1) + NW + NH + ND + 1 + np, lh);
+  put_halves (BC, EC);
+  put_halves (NW, NH);
+  put_halves (ND, 1);
+  put_halves (0, 0);
+  put_halves (0, np);
+
+  put_word (0);            /* checksum */
+  put_word (FIX (10.0));   /* design size */
+
+  for (c = BC; c <= EC; c++)
+    put_word (((long) width_of (c) << 24) | (height_of (c) << 20) | (depth_of (c) << 16));
+
+  for (k = 0; k < (int) NW; k++)
+    put_word (FIX (widths[k] * scale));
+  for (k = 0; k < (int) NH; k++)
+    put_word (FIX (heights[k]));
+  for (k = 0; k < (int) ND; k++)
+    put_word (FIX (depths[k]));
+  put_word (0);            /* the only italic correction */
+
+  for (k = 1; k <= np; k++)
+    put_word (params[k]);
+
+  if (fclose (tfm) != 0) {
+    perror (argv[2]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+#!/bin/sh
+# run-bench.sh -- run the benchmark corpus and compare with the baseline.
+#
+# usage: run-bench.sh [-u] [ENGINE]
+#
+# Every job in corpus/ is typeset RUNS times (default 5) by ENGINE
+# (default ../cpdfetex/cpdfetex) in a scratch directory.  For each job
+# the fastest wall-clock time, the peak resident set size and the size
+# of the PDF are printed and compared with the figures in `baseline';
+# the script fails when a time or memory figure is more than THRESHOLD
+# percent (default 10) above the baseline, or when a job fails.
+#
+# With -u the figures are written to `baseline' instead.  Timings are
+# only comparable on the machine the baseline was made on, so refresh it
+# (`make bench-baseline') before measuring a change.
+
+RUNS=${RUNS:-5}
+THRESHOLD=${THRESHOLD:-10}
+CC=${CC:-cc}
+
+update=no
+if [ "$1" = "-u" ]; then
+  update=yes
+  shift
+fi
+
+here=`cd \`dirname "$0"\` && pwd`
+engine=${1:-$here/../cpdfetex/cpdfetex}
+case "$engine" in
+  /*) ;;
+  *) engine=`pwd`/$engine ;;
+esac
+if [ ! -x "$engine" ]; then
+  echo "run-bench.sh: no engine at $engine" >&2
+  exit 1
+fi
+
+work=$here/work
+rm -rf "$work"
+mkdir -p "$work" || exit 1
+cd "$work" || exit 1
+
+# the helpers, the synthetic fonts and the configuration
+$CC -O2 -o mktfm "$here/mktfm.c" || exit 1
+$CC -O2 -o benchrun "$here/benchrun.c" || exit 1
+./mktfm text bnchrm.tfm || exit 1
+./mktfm symbol bnchsy.tfm || exit 1
+./mktfm extension bnchex.tfm || exit 1
+for e in 10 20 30; do
+  ./mktfm text bnchrm+$e.tfm $e || exit 1
+  ./mktfm text bnchrm-$e.tfm -$e || exit 1
+done
+cp "$here/pdftex.cfg" "$here/bench.map" "$here"/corpus/*.tex . || exit 1
+
+TEXINPUTS=.
+TFMFONTS=.
+export TEXINPUTS TFMFONTS
+
+# images.tex includes pages of paras.pdf, so paras comes first
+jobs="paras macros tables math images fontexp"
+
+status=0
+: > results
+printf '%-10s %10s %10s %10s\n' job seconds rss_kb pdf_bytes
+for job in $jobs; do
+  out=`./benchrun $RUNS $job.out "$engine" -ini -interaction=batchmode $job`
+  rc=$?
+  set -- $out
+  if [ $rc -ne 0 ] || [ ! -f $job.pdf ]; then
+    echo "$job: failed, see $work/$job.log" >&2
+    status=1
+    continue
+  fi
+  bytes=`wc -c < $job.pdf | tr -d ' '`
+  printf '%-10s %10s %10s %10s\n' $job $1 $2 $bytes
+  echo "$job $1 $2 $bytes" >> results
+done
+
+if [ $update = yes ]; then
+  if [ $status -ne 0 ]; then
+    echo "run-bench.sh: not updating the baseline after a failure" >&2
+    exit $status
+  fi
+  { echo "# job seconds rss_kb pdf_bytes -- written by run-bench.sh -u"
+    cat results; } > "$here/baseline"
+  echo "baseline updated"
+  exit 0
+fi
+
+if [ ! -f "$here/baseline" ]; then
+  echo "run-bench.sh: no baseline, run \`make bench-baseline' first" >&2
+  exit 1
+fi
+
+echo
+echo "change against the baseline (threshold $THRESHOLD%):"
+awk -v t=$THRESHOLD '
+  function pct(new, old) { return old > 0 ? 100 * (new - old) / old : 0 }
+  FNR == NR { if ($1 !~ /^#/) { sec[$1] = $2; rss[$1] = $3; pdf[$1] = $4 } next }
+  !($1 in sec) { printf "%-10s (not in the baseline)\n", $1; next }
+  {
+    ds = pct($2, sec[$1]); dr = pct($3, rss[$1]); dp = pct($4, pdf[$1])
+    flag = ""
+    if (ds > t) flag = flag " time"
+    if (dr > t) flag = flag " memory"
+    printf "%-10s %+9.1f%% %+9.1f%% %+9.1f%%%s\n", $1, ds, dr, dp, \
+      (flag != "" ? "  REGRESSION:" flag : "")
+    if (flag != "") bad = 1
+  }
+  END { exit bad }
+' "$here/baseline" results || status=1
+
+exit $status
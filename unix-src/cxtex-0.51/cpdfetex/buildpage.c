@@ -618,6 +618,7 @@ void build_page (void) { /* append contributions to the current page */
   if ((link (contrib_head) == null) || output_active) {
 	return;
   }
+  stats_enter (stats_build_page);
   do {
   CONTINUE:
 	p = link (contrib_head);
@@ -715,7 +716,7 @@ void build_page (void) { /* append contributions to the current page */
 	  if (page_contents < box_there) {
 		goto DONE1;
 	  } else if (link (p) == null) {
-		return;
+		goto EXIT;
 	  } else  if (type (link (p)) == glue_node) {
 		pi = 0;
 	  } else {
@@ -943,7 +944,7 @@ void build_page (void) { /* append contributions to the current page */
 	  if ((c == awful_bad) || (pi <= eject_penalty)) {
 		fire_up (p); /* output the current page at the best place */
 		if (output_active) {
-		  return; /* user's output routine will act */ 
+		  goto EXIT; /* user's output routine will act */ 
         } else { do_something; }
 		goto DONE; /* the page has been shipped out by default output routine */
 	  };
@@ -1022,6 +1023,8 @@ void build_page (void) { /* append contributions to the current page */
 	contrib_tail = contrib_head;	/* other modes */
   };
   /* end expansion of Make the contribution list empty by setting its tail to |contrib_head| */
+ EXIT:
+  stats_leave;
 };
 
 
@@ -38,14 +38,20 @@
 extern void printID(str_number);
 extern void dopdffont(integer, internal_font_number);
 extern void writezip(boolean);
+extern void writezip_defer(void);
+extern void writezip_submit(integer, char *);
+extern void writezip_collect(void);
 extern void writestreamlength(integer, integer);
 extern scaled getpkcharwidth(internal_font_number, scaled);
+extern char *pk_cache_dir;
 extern void checkextfm(str_number, integer);
 extern integer fmlookup(internal_font_number);
 extern internal_font_number tfmoffm(integer);
 extern integer newvfpacket(internal_font_number);
 extern void startpacket(internal_font_number,integer);
 extern void storepacket(integer, integer, integer);
+extern vf_instruction *packetcode(internal_font_number, integer);
+extern void storepacketcode(internal_font_number, integer, vf_instruction *);
 extern void setcharmap(internal_font_number);
 extern scaled extxnoverd(scaled, scaled, scaled);
 extern boolean ispdfimage(integer);
@@ -67,6 +73,7 @@ extern integer imagexres(integer);
 extern integer imageyres(integer);
 extern integer readimage(str_number, integer, str_number, integer, integer, integer);
 extern void pdfmapfile(integer);
+extern char *mapfiles;
 extern void libpdffinish  (void);
 
 extern char *makecstring (integer);
@@ -100,6 +100,52 @@ pointer pstack[9]; /* arguments supplied to a macro */
  * the control sequence \.{\\par}. If an illegal \.{\\par} appears, the macro
  * call is aborted, and the \.{\\par} will be rescanned.
  */
+/* The recovery from a partial match of a parameter delimiter (module 397)
+ * used to compare the matched tokens with the delimiter over and over.
+ * Now, the first time a partial match fails for a parameter, the
+ * delimiter is copied into |match_tok| and its Knuth--Morris--Pratt
+ * failure function is computed: |match_fail[j]| is the length of the
+ * longest proper prefix of the first |j| delimiter tokens that is also a
+ * suffix of them, and |match_node[j]| is the node of token |j|. The table
+ * is not kept beyond the parameter, because the token list it was made
+ * from may be freed and its nodes reused afterwards.
+ */
+static halfword *match_tok = NULL;
+static pointer *match_node = NULL;
+static integer *match_fail = NULL;
+static integer match_size = 0;
+
+static integer
+compile_delimiter (pointer s) { /* returns the length of the delimiter at |s| */
+  integer l, j, k;
+  l = 0;
+  loop {
+	if (l + 1 >= match_size) {
+	  match_size = 2 * match_size + 16;
+	  match_tok = xrealloc (match_tok, match_size * sizeof (halfword));
+	  match_node = xrealloc (match_node, match_size * sizeof (pointer));
+	  match_fail = xrealloc (match_fail, match_size * sizeof (integer));
+	};
+	if ((info (s) >= match_token) && (info (s) <= end_match_token))
+	  break;
+	match_tok[l] = info (s);
+	match_node[l] = s;
+	incr (l);
+	s = link (s);
+  };
+  match_fail[0] = 0;
+  match_fail[1] = 0;
+  k = 0;
+  for (j = 1; j < l; j++) {
+	while ((k > 0) && (match_tok[j] != match_tok[k]))
+	  k = match_fail[k];
+	if (match_tok[j] == match_tok[k])
+	  incr (k);
+	match_fail[j + 1] = k;
+  };
+  return l;
+}
+
 void
 macro_call (void) {				/* invokes a user-defined control sequence */
   pointer r; /* current node in the macro's token list */ 
@@ -107,7 +153,8 @@ macro_call (void) {				/* invokes a user-defined control sequence */
   pointer q; /* new node being put into the token list */ 
   pointer s; /* backup pointer for parameter matching */ 
   pointer t; /* cycle pointer for backup recovery */ 
-  pointer u, v; /* auxiliary pointers for backup recovery */ 
+  integer match_len; /* length of the compiled delimiter, or -1 */
+  integer i, j, k; /* matched delimiter tokens before and after backup */
   pointer rbrace_ptr; /* one step before the last |right_brace| token */ 
   small_number n; /* the number of parameters scanned */ 
   halfword unbalance; /* unmatched left braces in current parameter */ 
@@ -168,6 +215,7 @@ macro_call (void) {				/* invokes a user-defined control sequence */
 		p = temp_head;
 		m = 0;
 	  };
+	  match_len = -1;
 	  /* begin expansion of Scan a parameter until its delimiter string has been found; 
 		 or, if |s=null|, simply scan the delimiter string */
 	  /* module 392 */
@@ -233,29 +281,29 @@ macro_call (void) {				/* invokes a user-defined control sequence */
 		  return;
 		  /* end expansion of Report an improper use of the macro and abort */
 	    } else {
-		  t = s;
-		  do {
-		    store_new_token (info (t));
-		    incr (m);
-		    u = link (t);
-		    v = s;
-		    loop {
-		      if (u == r) {
-				if (cur_tok != info (v)) {
-				  goto DONE;
-				} else {
-				  r = link (v);
-				  goto CONTINUE;
-				}; 
-			  }
-		      if (info (u) != info (v))
-				goto DONE;
-		      u = link (u);
-		      v = link (v);
-		    };
-		  DONE:
-			t = link (t);
-		  } while (t != r);
+		  /* The longest suffix of the matched tokens followed by |cur_tok|
+		   * that is a prefix of the delimiter stays matched, the tokens
+		   * before it go to the parameter. */
+		  if (match_len < 0)
+			match_len = compile_delimiter (s);
+		  j = 0;
+		  for (t = s; t != r; t = link (t))
+			incr (j);
+		  k = match_fail[j];
+		  while ((k > 0) && (cur_tok != match_tok[k]))
+			k = match_fail[k];
+		  if (cur_tok == match_tok[k])
+			incr (k);
+		  if (k > 0)
+			j = j - k + 1;
+		  for (i = 0; i < j; i++) {
+			fast_store_new_token (match_tok[i]);
+			incr (m);
+		  };
+		  if (k > 0) {
+			r = match_node[k];
+			goto CONTINUE;
+		  };
 		  r = s; /* at this point, no tokens are recently matched */ 
 		}
 		/* end expansion of Contribute the recently matched tokens to the current.. */
@@ -288,7 +336,7 @@ macro_call (void) {				/* invokes a user-defined control sequence */
 		  };
 		DONE1:
 		  rbrace_ptr = p;
-		  store_new_token (cur_tok);
+		  fast_store_new_token (cur_tok);
 		  /* end expansion of Contribute an entire group to the current parameter */
 		} else {
 		  /* begin expansion of Report an extra right brace and |goto continue| */
@@ -318,7 +366,7 @@ macro_call (void) {				/* invokes a user-defined control sequence */
 		  if (info (r) <= end_match_token)
 			if (info (r) >= match_token)
 			  goto CONTINUE;
-		store_new_token (cur_tok);
+		fast_store_new_token (cur_tok);
 		/* end expansion of Store the current token, but |goto continue| if it is a blank ..*/
 	  };
 	  incr (m);
@@ -379,6 +427,7 @@ macro_call (void) {				/* invokes a user-defined control sequence */
 	  param_stack[param_ptr + m] = pstack[m];
 	param_ptr = param_ptr + n;
   };
+  profile_enter (warning_index);
   /* end expansion of Feed the macro body and its parameters to the scanner */
   scanner_status = save_scanner_status;
   warning_index = save_warning_index;
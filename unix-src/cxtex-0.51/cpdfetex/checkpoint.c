@@ -0,0 +1,541 @@
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "types.h"
+#include "c-compat.h"
+#include "globals.h"
+#include "mainio.h"
+#include "main.h"
+
+/* Checkpoints.
+ *
+ * A format can only be made by \.{INITEX}, at the outer level, before any
+ * output. Documents that share a long preamble can instead say
+ * \.{\\savecheckpoint} where the preamble ends; this writes the complete
+ * live state of the job to \.{\\jobname.ckp}: the string pool, |mem|,
+ * |eqtb| and the hash, the save stack, the current list and the page
+ * builder, the loaded fonts, the hyphenation exceptions, the \pdfTeX\
+ * memory and map files, and the input stack with the position reached in
+ * every open file. A later run with \.{--resume-from=FILE} loads the same
+ * format as usual, then restores that state instead of reading the first
+ * line, and so continues right after the \.{\\savecheckpoint}.
+ *
+ * The checkpoint remembers the size and modification time of every file
+ * that was \.{\\input} or \.{\\openin}ed before it was saved. If one of
+ * them has changed, or the format or the memory sizes are different, the
+ * checkpoint is ignored with a warning and the job starts from the
+ * beginning, so it is always safe to give the option.
+ *
+ * The state is saved only when it can be restored completely: between
+ * paragraphs at the outer level, with all input coming from files, no
+ * \.{\\read} or \.{\\write} stream open, and nothing written to the
+ * output file yet (that includes \PDF\ objects, images and fonts that
+ * have been referenced). The trie cannot change after \.{INITEX}, and
+ * virtual fonts are read only when shipping, so neither is saved.
+ */
+
+const_string resume_file_name = NULL;
+
+#define ckp_magic 1129009236 /* "CKPT" */
+#define ckp_version 1
+
+typedef struct {
+  char *path;
+  long long size, mtime;
+} ckp_file;
+
+static ckp_file *ckp_files = NULL; /* files read before the checkpoint */
+static integer ckp_files_ptr = 0;
+static integer ckp_files_size = 0;
+
+/* Called by |start_input| and |open_or_close_in| for every file opened */
+void
+checkpoint_note_file (const_string s) {
+  integer k;
+  for (k = 0; k < ckp_files_ptr; k++)
+	if (strcmp (ckp_files[k].path, s) == 0)
+	  return;
+  if (ckp_files_ptr == ckp_files_size) {
+	ckp_files_size = (ckp_files_size == 0 ? 16 : 2 * ckp_files_size);
+	ckp_files = xrealloc (ckp_files, ckp_files_size * sizeof (ckp_file));
+  }
+  ckp_files[ckp_files_ptr++].path = xstrdup (s);
+}
+
+static boolean
+ckp_stat (const_string s, long long *size, long long *mtime) {
+  struct stat st;
+  if (stat (s, &st) != 0)
+	return false;
+  *size = st.st_size;
+  *mtime = st.st_mtime;
+  return true;
+}
+
+static void
+ckp_dump_cstring (const_string s) {
+  integer l;
+  if (s == NULL) {
+	dump_int (-1);
+  } else {
+	l = strlen (s);
+	dump_int (l);
+	dump_things (s[0], l);
+  }
+}
+
+static char *
+ckp_undump_cstring (void) {
+  integer l;
+  char *s;
+  undump_int (l);
+  if (l < 0)
+	return NULL;
+  s = xmalloc (l + 1);
+  undump_things (s[0], l);
+  s[l] = 0;
+  return s;
+}
+
+/* Runs of equal words, for |eqtb| */
+static void
+ckp_dump_runs (memory_word *a, int from, int to) {
+  int j, k;
+  k = from;
+  while (k <= to) {
+	j = k + 1;
+	while ((j <= to) && (memcmp (&a[j], &a[k], sizeof (memory_word)) == 0))
+	  incr (j);
+	dump_int (j - k);
+	dump_wd (a[k]);
+	k = j;
+  }
+}
+
+/* The arrays indexed by internal font number */
+#define ckp_font_arrays(act)                                           \
+  act (font_check); act (font_size); act (font_dsize); act (font_params); \
+  act (font_name); act (font_area); act (font_bc); act (font_ec);       \
+  act (font_glue); act (hyphen_char); act (skew_char); act (bchar_label); \
+  act (font_bchar); act (font_false_bchar); act (char_base);            \
+  act (width_base); act (height_base); act (depth_base);                \
+  act (italic_base); act (lig_kern_base); act (kern_base);              \
+  act (exten_base); act (param_base);                                   \
+  act (pdf_char_used); act (pdf_char_map); act (pdf_font_size);         \
+  act (pdf_font_num); act (pdf_font_map); act (pdf_font_type);          \
+  act (pdf_font_attr); act (pdf_font_link); act (pdf_font_stretch);     \
+  act (pdf_font_shrink); act (pdf_font_step);                           \
+  act (pdf_font_expand_factor); act (pdf_font_expand_ratio);            \
+  act (pdf_font_lp_base); act (pdf_font_rp_base); act (pdf_font_ef_base)
+
+#define ckp_dump_font_array(a) dump_things (a[null_font], font_ptr + 1 - null_font)
+#define ckp_undump_font_array(a) undump_things (a[null_font], font_ptr + 1 - null_font)
+
+/* The scalar state, in the order it is written */
+#define ckp_globals(act)                                                \
+  act (cs_count); act (hash_used);                                      \
+  act (cur_level); act (cur_group); act (cur_boundary);                 \
+  act (sa_chain); act (sa_level);                                       \
+  act (page_tail); act (page_contents); act (page_max_depth);           \
+  act (best_page_break); act (least_page_cost); act (best_size);        \
+  act (last_glue); act (last_penalty); act (last_kern);                 \
+  act (last_node_type); act (insert_penalties); act (dead_cycles);      \
+  act (cond_ptr); act (if_limit); act (cur_if); act (if_line);          \
+  act (skip_line); act (LR_ptr); act (LR_problems); act (cur_dir);      \
+  act (pdf_info_toks); act (pdf_catalog_toks);                          \
+  act (pdf_catalog_openaction); act (pdf_names_toks);                   \
+  act (pdf_trailer_toks); act (pdf_line_snap_x); act (pdf_line_snap_y); \
+  act (mag_set); act (align_state); act (cur_lang); act (force_eof);    \
+  act (open_parens); act (jobname); act (interaction)
+
+#define ckp_dump_global(a) dump_int (a)
+#define ckp_undump_global(a) { undump_int (x); a = x; }
+
+/* Checkpoints can only be saved when the whole input stack consists of
+ * files on top of the terminal. Exhausted token lists are removed first,
+ * since \.{\\savecheckpoint} may well be the last token of a macro.
+ */
+static boolean
+ckp_input_is_files (void) {
+  unsigned int k;
+  while ((state == token_list) && (loc == null))
+	end_token_list();
+  input_stack[input_ptr] = cur_input;
+  if ((input_ptr == 0) || (input_ptr != in_open) || (pseudo_files != null))
+	return false;
+  for (k = 1; k <= input_ptr; k++)
+	if ((input_stack[k].state_field == token_list) || (input_stack[k].name_field <= 19))
+	  return false;
+  return true;
+}
+
+static boolean
+ckp_streams_open (void) {
+  int k;
+  for (k = 0; k <= 15; k++)
+	if ((read_open[k] != closed) || write_open[k])
+	  return true;
+  return false;
+}
+
+static boolean
+ckp_allowed (void) {
+  if (ini_version) {
+	print_err ("INITEX can't save checkpoints");
+	help1 ("Dump a format, and save the checkpoint in a run that uses it.");
+  } else if ((nest_ptr != 0) || (mode != vmode) || output_active) {
+	print_err ("You can't save a checkpoint here");
+	help2 ("A checkpoint can only be saved between paragraphs at the",
+		   "outer level, not in boxes, alignments or the output routine.");
+  } else if ((total_pages > 0) || (output_file_name != 0) || (obj_ptr != 0)) {
+	print_err ("You can't save a checkpoint after output has begun");
+	help2 ("It must come before the first page is shipped out, and before",
+		   "any PDF objects, images or fonts are referred to.");
+  } else if (!ckp_input_is_files()) {
+	print_err ("You can't save a checkpoint here");
+	help2 ("All pending input must come from files when a checkpoint is",
+		   "saved, not from macro arguments, \\scantokens or the terminal.");
+  } else if (ckp_streams_open()) {
+	print_err ("You can't save a checkpoint with open \\read or \\write files");
+	help1 ("Close them with \\closein or \\immediate\\closeout first.");
+  } else {
+	return true;
+  }
+  error();
+  return false;
+}
+
+/* The part of the file that |resume_checkpoint| checks before it changes
+ * anything: the format, the table sizes, and the files read so far.
+ */
+static void
+ckp_dump_header (void) {
+  integer k;
+  dump_int (ckp_magic);
+  dump_int (ckp_version);
+  ckp_dump_cstring (makecstring (format_ident));
+  dump_int (init_str_ptr);
+  dump_int (init_pool_ptr);
+  dump_int (mem_bot);
+  dump_int (mem_top);
+  dump_int (mem_min);
+  dump_int (mem_max);
+  dump_int (eqtb_size);
+  dump_int (hash_prime);
+  dump_int (hyph_size);
+  dump_int (font_max);
+  dump_int (max_in_open);
+  dump_int (str_ptr);
+  dump_int (pool_ptr);
+  dump_int (fmem_ptr);
+  dump_int (pdf_mem_ptr);
+  dump_int (ckp_files_ptr);
+  for (k = 0; k < ckp_files_ptr; k++) {
+	if (!ckp_stat (ckp_files[k].path, &ckp_files[k].size, &ckp_files[k].mtime))
+	  ckp_files[k].size = ckp_files[k].mtime = -1;
+	ckp_dump_cstring (ckp_files[k].path);
+	dump_things (ckp_files[k].size, 1);
+	dump_things (ckp_files[k].mtime, 1);
+  }
+}
+
+void
+save_checkpoint (void) {
+  int k;
+  long pos;
+  if (!ckp_allowed())
+	return;
+  pack_job_name (checkpoint_extension);
+  while (!w_open_out (fmt_file))
+	prompt_file_name ("checkpoint file name", checkpoint_extension);
+  print_nl_string ("Saving a checkpoint on ");
+  slow_print (w_make_name_string (fmt_file));
+  flush_string;
+  print_char ('.');
+  print_ln();
+  ckp_dump_header();
+  /* the strings made after the format was loaded */
+  dump_things (str_start[init_str_ptr], str_ptr + 1 - init_str_ptr);
+  dump_things (str_pool[init_pool_ptr], pool_ptr - init_pool_ptr);
+  /* the dynamic memory, all of it that is in use */
+  dump_int (lo_mem_max);
+  dump_int (rover);
+  dump_int (hi_mem_min);
+  dump_int (avail);
+  dump_int (mem_end);
+  dump_int (var_used);
+  dump_int (dyn_used);
+  dump_things (mem[mem_min], lo_mem_max + 1 - mem_min);
+  dump_things (mem[hi_mem_min], mem_end + 1 - hi_mem_min);
+  /* the table of equivalents and the hash */
+  ckp_dump_runs (eqtb, active_base, eqtb_size);
+  dump_things (xeq_level[int_base], eqtb_size + 1 - int_base);
+  for (k = hash_base; k < undefined_control_sequence; k++)
+	if ((next (k) != 0) || (text (k) != 0)) {
+	  dump_int (k);
+	  dump_hh (hash[k]);
+	}
+  dump_int (0);
+  /* everything else that lives in |mem| or points into it */
+  ckp_globals (ckp_dump_global);
+  dump_int (save_ptr);
+  dump_things (save_stack[0], save_ptr);
+  dump_things (cur_list, 1);
+  dump_things (page_so_far[0], 8);
+  dump_things (cur_mark[0], split_bot_mark_code + 1);
+  dump_things (disc_ptr[0], vsplit_code + 1);
+  dump_things (sa_root[0], mark_val + 1);
+  /* the fonts */
+  dump_things (font_info[0], fmem_ptr);
+  dump_int (font_ptr);
+  ckp_font_arrays (ckp_dump_font_array);
+  dump_int (hyph_count);
+  dump_int (hyph_next);
+  dump_things (hyph_word[0], hyph_size + 1);
+  dump_things (hyph_list[0], hyph_size + 1);
+  dump_things (hyph_link[0], hyph_size + 1);
+  dump_things (pdf_mem[0], pdf_mem_ptr);
+  ckp_dump_cstring (mapfiles);
+  /* the input stack and the open files */
+  dump_int (first);
+  dump_int (last);
+  dump_things (buffer[0], first);
+  dump_int (input_ptr);
+  dump_things (input_stack[0], input_ptr + 1);
+  dump_int (line);
+  dump_things (line_stack[0], in_open + 1);
+  dump_things (eof_seen[0], in_open + 1);
+  dump_things (grp_stack[0], in_open + 1);
+  dump_things (if_stack[0], in_open + 1);
+  dump_things (source_filename_stack[0], in_open + 1);
+  dump_things (full_source_filename_stack[0], in_open + 1);
+  for (k = 1; k <= (int)in_open; k++) {
+	pos = ftell (input_file[k]);
+	dump_things (pos, 1);
+  }
+  dump_int (69069);
+  w_close (fmt_file);
+}
+
+/* The sizes read by |ckp_header_ok|, installed once it has succeeded */
+static integer ckp_str_ptr, ckp_pool_ptr, ckp_fmem_ptr, ckp_pdf_mem_ptr;
+
+/* Returns |false|, after a warning, if the checkpoint cannot be used */
+static boolean
+ckp_header_ok (void) {
+  integer k, n, x;
+  char *s, *why;
+  long long size, mtime, cur_size, cur_mtime;
+  why = NULL;
+  undump_int (x);
+  if (x != ckp_magic)
+	why = "not a checkpoint file";
+  if (why == NULL) {
+	undump_int (x);
+	if (x != ckp_version)
+	  why = "made by a different version of the program";
+  }
+  if (why == NULL) {
+	s = ckp_undump_cstring();
+	if (s == NULL)
+	  why = "damaged";
+	else if (strcmp (s, makecstring (format_ident)) != 0)
+	  why = "made with a different format";
+	free (s);
+  }
+#define ckp_check(a) { undump_int (x); if ((why == NULL) && (x != (a))) why = "made with different table sizes"; }
+  if (why == NULL) {
+	ckp_check (init_str_ptr);
+	ckp_check (init_pool_ptr);
+	ckp_check (mem_bot);
+	ckp_check (mem_top);
+	ckp_check (mem_min);
+	ckp_check (mem_max);
+	ckp_check (eqtb_size);
+	ckp_check (hash_prime);
+	ckp_check (hyph_size);
+	ckp_check (font_max);
+	ckp_check (max_in_open);
+  }
+#undef ckp_check
+  if (why == NULL) {
+	undump_int (ckp_str_ptr);
+	if (ckp_str_ptr >= max_strings)
+	  why = "too large for max_strings";
+	undump_int (ckp_pool_ptr);
+	if (ckp_pool_ptr >= pool_size)
+	  why = "too large for pool_size";
+	undump_int (ckp_fmem_ptr);
+	if (ckp_fmem_ptr > font_mem_size)
+	  why = "too large for font_mem_size";
+	undump_int (ckp_pdf_mem_ptr);
+	if (ckp_pdf_mem_ptr > pdf_mem_size)
+	  why = "too large for pdf_mem_size";
+  }
+  if (why == NULL) {
+	undump_int (n);
+	for (k = 0; k < n; k++) {
+	  s = ckp_undump_cstring();
+	  if (s == NULL) {
+		why = "damaged";
+		break;
+	  }
+	  undump_things (size, 1);
+	  undump_things (mtime, 1);
+	  if ((why == NULL) && (!ckp_stat (s, &cur_size, &cur_mtime)
+							|| (cur_size != size) || (cur_mtime != mtime))) {
+		WARNING2 ("Checkpoint `%s' is out of date: `%s' has changed", resume_file_name, s);
+		why = "";
+	  }
+	  free (s);
+	}
+  }
+  if (why != NULL) {
+	if (*why != 0)
+	  WARNING2 ("Checkpoint `%s' is %s", resume_file_name, why);
+	WARNING ("Starting from the beginning");
+	return false;
+  }
+  return true;
+}
+
+#define ckp_damaged FATAL1 ("Checkpoint `%s' is damaged", resume_file_name)
+
+#define ckp_undump(low, high, var) { undump_int (x);                 \
+	if ((x < (low)) || (x > (high))) ckp_damaged; else var = x; }
+
+/* Called by |main_body| instead of reading the first line of input.
+ * When it returns |true|, the job goes on where the checkpoint was saved.
+ */
+boolean
+resume_checkpoint (void) {
+  int j, k, x;
+  long pos;
+  char *s;
+  if (resume_file_name == NULL)
+	return false;
+  fmt_file = fopen (resume_file_name, FOPEN_RBIN_MODE);
+  if (fmt_file == NULL) {
+	WARNING1 ("Can't read the checkpoint `%s', starting from the beginning", resume_file_name);
+	return false;
+  }
+  if (!ckp_header_ok()) {
+	w_close (fmt_file);
+	return false;
+  }
+  /* The configuration would override the restored parameters if it were
+	 read afterwards, as it normally is */
+  read_values_from_config_file();
+  if ((ckp_str_ptr < init_str_ptr) || (ckp_pool_ptr < init_pool_ptr)
+	  || (ckp_fmem_ptr < fmem_ptr) || (ckp_pdf_mem_ptr < 1))
+	ckp_damaged;
+  str_ptr = ckp_str_ptr;
+  pool_ptr = ckp_pool_ptr;
+  fmem_ptr = ckp_fmem_ptr;
+  pdf_mem_ptr = ckp_pdf_mem_ptr;
+  undump_things (str_start[init_str_ptr], str_ptr + 1 - init_str_ptr);
+  undump_things (str_pool[init_pool_ptr], pool_ptr - init_pool_ptr);
+  ckp_undump (lo_mem_stat_max + 1000, mem_max, lo_mem_max);
+  ckp_undump (lo_mem_stat_max + 1, lo_mem_max, rover);
+  ckp_undump (lo_mem_max + 1, hi_mem_stat_min, hi_mem_min);
+  ckp_undump (null, mem_max, avail);
+  ckp_undump (mem_top, mem_max, mem_end);
+  undump_int (var_used);
+  undump_int (dyn_used);
+  undump_things (mem[mem_min], lo_mem_max + 1 - mem_min);
+  undump_things (mem[hi_mem_min], mem_end + 1 - hi_mem_min);
+  k = active_base;
+  while (k <= eqtb_size) {
+	undump_int (x);
+	if ((x < 1) || (k + x - 1 > eqtb_size))
+	  ckp_damaged;
+	undump_wd (eqtb[k]);
+	for (j = k + 1; j < k + x; j++)
+	  eqtb[j] = eqtb[k];
+	k = k + x;
+  }
+  undump_things (xeq_level[int_base], eqtb_size + 1 - int_base);
+  cat_class_valid = false;
+  memset (&hash[hash_base], 0, (undefined_control_sequence - hash_base) * sizeof (two_halves));
+  loop {
+	ckp_undump (0, undefined_control_sequence - 1, k);
+	if (k == 0)
+	  break;
+	if (k < hash_base)
+	  ckp_damaged;
+	undump_hh (hash[k]);
+  }
+  ckp_globals (ckp_undump_global);
+  if (interaction_option != unspecified_mode)
+	interaction = interaction_option;
+  ckp_undump (0, max_halfword, save_ptr);
+  while (save_ptr > save_size - 7) {
+	save_stack = xrealloc_array (save_stack, sizeof (memory_word) * save_size * 2);
+	save_size = 2 * save_size;
+  }
+  max_save_stack = save_ptr;
+  undump_things (save_stack[0], save_ptr);
+  undump_things (cur_list, 1);
+  undump_things (page_so_far[0], 8);
+  undump_things (cur_mark[0], split_bot_mark_code + 1);
+  undump_things (disc_ptr[0], vsplit_code + 1);
+  undump_things (sa_root[0], mark_val + 1);
+  sa_clear_map ();
+  undump_things (font_info[0], fmem_ptr);
+  ckp_undump (font_base, font_max, font_ptr);
+  ckp_font_arrays (ckp_undump_font_array);
+  ckp_undump (0, hyph_size, hyph_count);
+  ckp_undump (0, hyph_size, hyph_next);
+  undump_things (hyph_word[0], hyph_size + 1);
+  undump_things (hyph_list[0], hyph_size + 1);
+  undump_things (hyph_link[0], hyph_size + 1);
+  undump_things (pdf_mem[0], pdf_mem_ptr);
+  s = ckp_undump_cstring();
+  free (mapfiles);
+  mapfiles = s;
+  undump_int (first);
+  undump_int (last);
+  while (first + 1 >= (unsigned)buf_size)
+	realloc_buffer();
+  undump_things (buffer[0], first);
+  if (max_buf_stack < (integer)first)
+	max_buf_stack = first;
+  ckp_undump (1, max_in_open, input_ptr);
+  if (input_ptr >= (unsigned)stack_size)
+	ckp_damaged;
+  undump_things (input_stack[0], input_ptr + 1);
+  cur_input = input_stack[input_ptr];
+  in_open = input_ptr;
+  max_in_stack = input_ptr;
+  undump_int (line);
+  undump_things (line_stack[0], in_open + 1);
+  undump_things (eof_seen[0], in_open + 1);
+  undump_things (grp_stack[0], in_open + 1);
+  undump_things (if_stack[0], in_open + 1);
+  undump_things (source_filename_stack[0], in_open + 1);
+  undump_things (full_source_filename_stack[0], in_open + 1);
+  for (k = 1; k <= (int)in_open; k++) {
+	undump_things (pos, 1);
+	s = makecstring (full_source_filename_stack[k]);
+	input_file[k] = fopen (s, FOPEN_RBIN_MODE);
+	if ((input_file[k] == NULL) || (fseek (input_file[k], pos, SEEK_SET) != 0))
+	  FATAL2 ("Can't reopen `%s' for checkpoint `%s'", s, resume_file_name);
+  }
+  undump_int (x);
+  if ((x != 69069) || feof (fmt_file))
+	ckp_damaged;
+  w_close (fmt_file);
+  /* The date and time are those of this run, not of the checkpoint */
+  fix_date_and_time;
+  open_log_file();
+  print_nl_string ("Resuming from the checkpoint ");
+  zprint_string ((char *)resume_file_name);
+  for (k = 1; k <= (int)in_open; k++) {
+	print_char (' ');
+	print_char ('(');
+	slow_print (full_source_filename_stack[k]);
+  }
+  update_terminal;
+  return true;
+}
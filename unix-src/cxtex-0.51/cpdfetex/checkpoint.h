@@ -0,0 +1,16 @@
+
+/* Checkpoints of the engine state, see checkpoint.c */
+
+/* The chr code of \.{\\savecheckpoint}; it continues the |extension|
+ * codes of pdfproc.h.
+ */
+#define save_checkpoint_code 35
+
+#define checkpoint_extension ".ckp"
+
+EXTERN const_string resume_file_name; /* name given to \.{--resume-from}, or |NULL| */
+
+EXTERN void checkpoint_note_file (const_string s);
+EXTERN void save_checkpoint (void);
+EXTERN boolean resume_checkpoint (void);
+
@@ -1258,6 +1258,9 @@ print_cmd_chr (quarterword cmd, halfword chr_code) {
 	case pdf_trailer_code:
 	  print_esc_string ("pdftrailer");
 	  break;
+	case save_checkpoint_code:
+	  print_esc_string ("savecheckpoint");
+	  break;
 	default:
 	  zprint_string("[unknown extension!]");
 	};
@@ -1751,11 +1754,13 @@ end_token_list (void) {	/* leave a token-list input level */
 		flush_list (start);
 	  } else {
 		delete_token_ref (start); /* update reference count */
-		if (token_type == macro)	    /* parameters must be flushed */
+		if (token_type == macro) {	    /* parameters must be flushed */
 		  while (param_ptr > (unsigned)param_start) {
 			decr (param_ptr);
 			flush_list (param_stack[param_ptr]);
 	      };
+		  profile_leave;
+		};
 	  };
   } else if (token_type == u_template) {
     if (align_state > 500000) {
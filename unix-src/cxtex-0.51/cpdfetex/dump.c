@@ -64,6 +64,12 @@ store_fmt_file (void) {
 	help1 ("`{...\\dump}' is a no-no.");
 	succumb;
   };
+  if ((mem_min != mem_bot) || (mem_max != mem_top)) {
+	print_err ("You can't dump after -auto-grow has enlarged the memory");
+	help2 ("Only mem[mem_bot..mem_top] goes into a format file;",
+		   "run INITEX again with a larger main_memory.");
+	succumb;
+  };
   /* end expansion of If dumping is not allowed, abort */
   /* begin expansion of Create the |format_ident|, open the format file, and inform the user that dumping has begun */
   /* module 1473 */
@@ -420,7 +426,7 @@ boolean load_fmt_file (void) {
 	libc_free (str_pool);
 	libc_free (str_start);
 	libc_free (eqtb);
-	libc_free (yzmem);
+	mem_free ();
   }
   undump_int (x);
   if (x != max_halfword)
@@ -459,7 +465,7 @@ boolean load_fmt_file (void) {
   page_tail = page_head; /* page initialization */ 
   mem_min =  mem_bot - extra_mem_bot;
   mem_max = mem_top + extra_mem_top;
-  yzmem = xmalloc_array (memory_word, mem_max - mem_min);
+  yzmem = mem_alloc (mem_min, mem_max);
   mem = yzmem - mem_min; /* this pointer arithmetic fails with some compilers */
   undump_int (x);
   if (x != eqtb_size)
@@ -505,6 +511,7 @@ boolean load_fmt_file (void) {
       undump (null,lo_mem_max,sa_root[k]);
 	}
   }
+  sa_clear_map ();
   p = mem_bot;
   q = rover;
   do {
@@ -560,7 +567,7 @@ boolean load_fmt_file (void) {
 	};
 	k=k+x;
   } while (k<=eqtb_size);
-
+  cat_class_valid = false;
   /* end expansion of Undump regions 1 to 6 of |eqtb| */
   /* a direct call to |undump_int| removes the need for some hash globals,
    * just for the next two lines. Since this is rather static data, that
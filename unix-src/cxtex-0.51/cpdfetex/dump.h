@@ -89,7 +89,14 @@
 	generic_dump (x_val);												\
   } while (0)
 
-#define undump_int generic_undump
+/* Likewise `undump_int' always reads a whole |integer|, whatever the
+   type of its argument; |integer| is wider than |int| on LP64 hosts.  */
+#define undump_int(x)                                                   \
+  do {                                                                  \
+	integer x_val;														\
+	generic_undump (x_val);												\
+	(x) = x_val;														\
+  } while (0)
 
 
 EXTERN const_string dump_name;
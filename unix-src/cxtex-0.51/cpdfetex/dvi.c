@@ -544,19 +544,18 @@ int lq, lr; /* quantities used in calculations for leaders */
  * changed to a `|y2|', thereby making a subsequent `|y0|' command possible,
  * saving two bytes.
  * 
- * The output buffer is divided into two parts of equal size; the bytes found
- * in |dvi_buf[0..half_buf-1]| constitute the first half, and those in
- * |dvi_buf[half_buf..dvi_buf_size-1]| constitute the second. The global
+ * The output buffer always holds the whole of the page being shipped out,
+ * so that every command of the page can still be changed. The global
  * variable |dvi_ptr| points to the position that will receive the next
  * output byte. When |dvi_ptr| reaches |dvi_limit|, which is always equal
- * to one of the two values |half_buf| or |dvi_buf_size|, the half buffer that
- * is about to be invaded next is sent to the output and |dvi_limit| is
- * changed to its other value. Thus, there is always at least a half buffer's
- * worth of information present, except at the very beginning of the job.
+ * to |dvi_buf_size|, the buffer is doubled in size. Complete pages are
+ * sent to the output in blocks, when a page ends and the buffer is at
+ * least half full, and at the end of the job.
  * 
  * Bytes of the \.{DVI} file are numbered sequentially starting with 0;
  * the next byte to be generated will be number |dvi_offset+dvi_ptr|.
- * A byte is present in the buffer only if its number is |>=dvi_gone|.
+ * A byte is present in the buffer only if its number is |>=dvi_gone|;
+ * here |dvi_gone=dvi_offset| always.
  */
 
 
@@ -567,11 +566,9 @@ int lq, lr; /* quantities used in calculations for leaders */
  */
 
 eight_bits *dvi_buf; /* buffer for \.{DVI} output */
-int half_buf; /* half of |dvi_buf_size| */
-int dvi_limit; /* end of the current half buffer */
+int dvi_limit; /* end of the buffer */
 int dvi_ptr; /* the next available buffer address */
-int dvi_offset; /* |dvi_buf_size| times the number of times the 
-				   output buffer has been fully emptied */
+int dvi_offset; /* the number of bytes output before |dvi_buf[0]| */
 integer dvi_gone; /* the number of bytes already output to |dvi_file| */
 
 /* module 597 */
@@ -579,10 +576,7 @@ integer dvi_gone; /* the number of bytes already output to |dvi_file| */
 /* The actual output of |dvi_buf[a..b]| to |dvi_file| is performed by calling
  * |write_dvi(a,b)|. For best results, this procedure should be optimized to
  * run as fast as possible on each particular system, since it is part of
- * \TeX's inner loop. It is safe to assume that |a| and |b+1| will both be
- * multiples of 4 when |write_dvi(a,b)| is called; therefore it is possible on
- * many machines to use efficient methods to pack four bytes per word and to
- * output an array of words with one system call.
+ * \TeX's inner loop.
  * 
  * In C, we use a macro to call |fwrite| or |write| directly, writing all
  * the bytes in one shot. Much better even than writing four
@@ -607,19 +601,36 @@ integer dvi_gone; /* the number of bytes already output to |dvi_file| */
  * each time, we use the macro |dvi_out|.
  */
 void
-dvi_swap (void) { /* outputs half of the buffer */
-  if (dvi_limit == dvi_buf_size) {
-	write_dvi (0, half_buf - 1);
-	dvi_limit = half_buf;
-	dvi_offset = dvi_offset + dvi_buf_size;
-	dvi_ptr = 0;
+dvi_swap (void) { /* doubles the buffer */
+  dvi_buf = xrealloc_array (dvi_buf, sizeof (eight_bits) * (dvi_buf_size * 2 + 1));
+  if (dvi_buf == NULL) {
+	overflow ("output buffer size", dvi_buf_size);
   } else {
-	write_dvi (half_buf, dvi_buf_size - 1);
-	dvi_limit = dvi_buf_size;
-  };
-  dvi_gone = dvi_gone + half_buf;
+	dvi_buf_size = dvi_buf_size * 2;
+  }
+  dvi_limit = dvi_buf_size;
 };
 
+/* Strings are put into the buffer with a single copy */
+static void
+dvi_out_block (eight_bits *s, int n) {
+  while (dvi_ptr + n >= dvi_limit)
+	dvi_swap();
+  memcpy (dvi_buf + dvi_ptr, s, n);
+  dvi_ptr = dvi_ptr + n;
+}
+
+/* Called after each |eop|, and with |force| at the end of the job */
+static void
+dvi_flush (boolean force) {
+  if ((dvi_ptr > 0) && (force || (dvi_ptr >= dvi_buf_size / 2))) {
+	write_dvi (0, dvi_ptr - 1);
+	dvi_offset = dvi_offset + dvi_ptr;
+	dvi_gone = dvi_offset;
+	dvi_ptr = 0;
+  }
+}
+
 
 /* module 600 */
 
@@ -664,10 +675,29 @@ dvi_pop (int l) {
 
 /* Here's a procedure that outputs a font definition. Since \TeX82 uses at
  * most 256 different fonts per job, |fnt_def1| is always used as the command code.
+ *
+ * Every definition is needed twice, when the font is first used and again
+ * in the postamble, so the bytes are kept the first time and copied the
+ * second.
  */
+static eight_bits **font_def_bytes = NULL; /* the definitions made so far */
+static int *font_def_length;
+
 void
 dvi_font_def (internal_font_number f) {
   pool_pointer k; /* index into |str_pool| */ 
+  int l; /* where the definition starts in |dvi_buf| */
+  if (font_def_bytes == NULL) {
+	font_def_bytes = xmalloc_array (eight_bits *, font_max);
+	font_def_length = xmalloc_array (int, font_max);
+	for (l = 0; l <= font_max; l++)
+	  font_def_bytes[l] = NULL;
+  }
+  if (font_def_bytes[f] != NULL) {
+	dvi_out_block (font_def_bytes[f], font_def_length[f]);
+	return;
+  }
+  l = dvi_ptr;
   if (f <= 256 + font_base) {
 	dvi_out (fnt_def1);
 	dvi_out (f - font_base - 1);
@@ -691,6 +721,9 @@ dvi_font_def (internal_font_number f) {
   for (k = str_start[font_name[f]]; k <= str_start[font_name[f] + 1] - 1; k++)
     dvi_out (str_pool[k]);
   /* end expansion of Output the font name whose internal number is |f| */
+  font_def_length[f] = dvi_ptr - l;
+  font_def_bytes[f] = xmalloc_array (eight_bits, font_def_length[f]);
+  memcpy (font_def_bytes[f], dvi_buf + l, font_def_length[f]);
 };
 
 
@@ -756,11 +789,25 @@ dvi_font_def (internal_font_number f) {
  * |dvi_offset|); the |link| field points to the next item below this one
  * on the stack; and the |info| field encodes the options for possible change
  * in the \.{DVI} command.
+ *
+ * Two more links save |movement| from looking at every entry of a deep
+ * stack: |width_link| points to the next entry below with a width in the
+ * same bucket of the stack's |movement_hash|, and |here_link| of a |y_here|
+ * (|z_here|) entry to the next |y_here| (|z_here|) entry below it. The tops
+ * of those chains are kept in |movement_hash| and |y_here_ptr|, |z_here_ptr|;
+ * index 0 of these is for the down stack and 1 for the right stack.
  */
-#define movement_node_size 3
+#define movement_node_size 4
 #define location( arg )  mem [ arg  + 2 ]. cint
+#define width_link( arg ) link ( arg  + 3 )
+#define here_link( arg ) info ( arg  + 3 )
+#define movement_hash_size 64
+#define movement_hash_code( arg ) (((((unsigned) ( arg )) * 2654435769U) >> 26) % movement_hash_size)
 
 pointer down_ptr, right_ptr; /* heads of the down and right stacks */
+static pointer movement_hash[2][movement_hash_size]; /* tops of the width chains */
+static pointer y_here_ptr[2], z_here_ptr[2]; /* tops of the |y_here| and |z_here| chains */
+integer dvi_movements, dvi_movements_reused; /* commands made by |movement| and those that are |w0|..|z0| */
 
 /* module 608 */
 
@@ -816,17 +863,28 @@ void
 movement (scaled w, eight_bits o) {
   small_number mstate; /* have we seen a |y| or |z|? */ 
   pointer p, q; /* current and top nodes on the stack */ 
-  int k; /* index into |dvi_buf|, modulo |dvi_buf_size| */ 
+  int k; /* index into |dvi_buf| */ 
+  int d; /* 0 for the down stack, 1 for the right stack */
+  int h; /* the bucket of |w| in |movement_hash[d]| */
+  pointer y, z; /* the highest |y_here| and |z_here| nodes */
+  integer bottom; /* the search ends below this location */
   q = get_node (movement_node_size); /* new node for the top of the stack */ 
   width (q) = w;
   location (q) = dvi_offset + dvi_ptr;
   if (o == down1) {
 	link (q) = down_ptr;
 	down_ptr = q;
+	d = 0;
   } else {
 	link (q) = right_ptr;
 	right_ptr = q;
+	d = 1;
   };
+  h = movement_hash_code (w);
+  width_link (q) = movement_hash[d][h];
+  movement_hash[d][h] = q;
+  here_link (q) = null;
+  incr (dvi_movements);
   /* begin expansion of Look at the other stack entries until deciding what sort 
 	 of \.{DVI} command to generate; |goto found| if node |p| is a ``hit'' */
   /* module 611 */
@@ -835,11 +893,27 @@ movement (scaled w, eight_bits o) {
    * encountered |y_here| or |z_here| nodes. These states are encoded as
    * multiples of 6, so that they can be added to the |info| fields for quick
    * decision-making.
+   *
+   * Only the nodes of matching width can be hits, so only those are visited,
+   * by way of the width chain; the state at each of them follows from the
+   * locations of the highest |y_here| and |z_here| nodes. The search would
+   * give up at the lower of those two, so nodes below it are not visited.
    */
-  p = link (q);
-  mstate = none_seen;
-  while (p != null) {
+  y = y_here_ptr[d];
+  z = z_here_ptr[d];
+  if ((y != null) && (z != null)) {
+	bottom = (location (y) < location (z) ? location (y) : location (z));
+  } else {
+	bottom = -1;
+  }
+  p = width_link (q);
+  while ((p != null) && (location (p) >= bottom)) {
 	if (width (p) == w) {
+	  mstate = none_seen;
+	  if ((y != null) && (location (y) > location (p)))
+		mstate = y_seen;
+	  if ((z != null) && (location (z) > location (p)))
+		mstate = z_seen;
 	  /* begin expansion of Consider a node with matching width; |goto found| if it's a hit */
 	  /* module 612 */
 	  /* We might find a valid hit in a |y| or |z| byte that is already gone
@@ -857,10 +931,10 @@ movement (scaled w, eight_bits o) {
 		  /* begin expansion of Change buffered instruction to |y| or |w| and |goto found| */
 		  /* module 613 */
 		  k = location (p) - dvi_offset;
-		  if (k < 0)
-			k = k + dvi_buf_size;
 		  dvi_buf[k] = dvi_buf[k] + y1 - down1;
 		  info (p) = y_here;
+		  here_link (p) = y_here_ptr[d]; /* no |y_here| node is higher */
+		  y_here_ptr[d] = p;
 		  goto FOUND;
 		  /* end expansion of Change buffered instruction to |y| or |w| and |goto found| */
 		}
@@ -873,10 +947,10 @@ movement (scaled w, eight_bits o) {
 		  /* begin expansion of Change buffered instruction to |z| or |x| and |goto found| */
 		  /* module 614 */
 		  k = location (p) - dvi_offset;
-		  if (k < 0)
-			k = k + dvi_buf_size;
 		  dvi_buf[k] = dvi_buf[k] + z1 - down1;
 		  info (p) = z_here;
+		  here_link (p) = z_here_ptr[d]; /* no |z_here| node is higher */
+		  z_here_ptr[d] = p;
 		  goto FOUND;
 		  /* end expansion of Change buffered instruction to |z| or |x| and |goto found| */
 		};
@@ -890,23 +964,8 @@ movement (scaled w, eight_bits o) {
 		do_nothing;
 	  }
 	  /* end expansion of Consider a node with matching width; |goto found| if it's a hit */
-	} else {
-	  switch (mstate + info (p)) {
-	  case none_seen + y_here:
-	    mstate = y_seen;
-	    break;
-	  case none_seen + z_here:
-	    mstate = z_seen;
-	    break;
-	  case y_seen + z_here:
-	  case z_seen + y_here:
-		do_something;
-	    goto NOT_FOUND;
-	  default:
-	    do_nothing;
-	  };
-    };
-	p = link (p);
+	};
+	p = width_link (p);
   };
  NOT_FOUND:
   /* end expansion of Look at the other stack entries until deciding what sor... */
@@ -951,8 +1010,11 @@ movement (scaled w, eight_bits o) {
    * the procedure generates a |y0| command (or a |w0| command), and marks
    * all |info| fields between |q| and |p| so that |y| is not OK in that range.
    */
+  incr (dvi_movements_reused);
   info (q) = info (p);
   if (info (q) == y_here) {
+	here_link (q) = y_here_ptr[d];
+	y_here_ptr[d] = q;
 	dvi_out (o + y0 - down1); /* |y0| or |w0| */ 
 	while (link (q) != p) {
 	  q = link (q);
@@ -968,6 +1030,8 @@ movement (scaled w, eight_bits o) {
 	  };
 	};
   } else {
+	here_link (q) = z_here_ptr[d];
+	z_here_ptr[d] = q;
 	dvi_out (o + z0 - down1); /* |z0| or |x0| */ 
 	while (link (q) != p) {
 	  q = link (q);
@@ -1043,6 +1107,20 @@ int cur_s; /* current depth of output box nesting, initially $-1$ */
  * down and right stacks to the state they were in before the box was output,
  * except that some |info|'s may have become more restrictive.
  */
+/* A node being deleted is at the top of its width chain, and of its
+ * |y_here| or |z_here| chain if it is in one.
+ */
+static void
+pop_movement (int d, pointer p) {
+  movement_hash[d][movement_hash_code (width (p))] = width_link (p);
+  if (info (p) == y_here) {
+	y_here_ptr[d] = here_link (p);
+  } else if (info (p) == z_here) {
+	z_here_ptr[d] = here_link (p);
+  }
+  free_node (p, movement_node_size);
+}
+
 void
 prune_movements (int l) { /* delete movement nodes with |location>=l| */
   pointer p; /* node being deleted */ 
@@ -1051,7 +1129,7 @@ prune_movements (int l) { /* delete movement nodes with |location>=l| */
 	  goto DONE;
 	p = down_ptr;
 	down_ptr = link (p);
-	free_node (p, movement_node_size);
+	pop_movement (0, p);
   };
  DONE:
   while (right_ptr != null) {
@@ -1059,7 +1137,7 @@ prune_movements (int l) { /* delete movement nodes with |location>=l| */
 	  return;
 	p = right_ptr;
 	right_ptr = link (p);
-	free_node (p, movement_node_size);
+	pop_movement (1, p);
   };
 }
 
@@ -1704,7 +1782,6 @@ void
 dvi_ship_out (pointer p) { /* output the box |p| */
   int page_loc; /* location of the current |bop| */ 
   unsigned char j, k; /* indices to first ten count registers */ 
-  pool_pointer s; /* index into |str_pool| */ 
   unsigned char old_setting; /* saved |selector| setting */ 
   if (tracing_output > 0) {
 	print_nl_string("");
@@ -1787,8 +1864,7 @@ dvi_ship_out (pointer p) { /* output the box |p| */
 	  print_two (tex_time % 60);
 	  selector = old_setting;
 	  dvi_out (cur_length);
-	  for (s = str_start[str_ptr]; s <= pool_ptr - 1; s++)
-		dvi_out (str_pool[s]);
+	  dvi_out_block (&str_pool[str_start[str_ptr]], cur_length);
 	  pool_ptr = str_start[str_ptr]; /* flush the current string */ 
   }
   /* end expansion of Initialize variables as |ship_out| begins */
@@ -1808,6 +1884,7 @@ dvi_ship_out (pointer p) { /* output the box |p| */
   dvi_out (eop);
   incr (total_pages);
   cur_s = -1;
+  dvi_flush (false);
  DONE:
 /* end expansion of Ship box |p| out */
   if (eTeX_ex)
@@ -1842,12 +1919,10 @@ dvi_ship_out (pointer p) { /* output the box |p| */
 
 /* module 593 */
 /* module 596 */
-/* Initially the buffer is all in one piece; we will output half of it only
- * after it first fills up.
- */
 /* module 606 */
 void
 dvi_initialize (void) {
+  int k;
   total_pages = 0;
   max_v = 0;
   max_h = 0;
@@ -1857,7 +1932,6 @@ dvi_initialize (void) {
   dead_cycles = 0;
   cur_s = -1;
 
-  half_buf = dvi_buf_size / 2;
   dvi_limit = dvi_buf_size;
   dvi_ptr = 0;
   dvi_offset = 0;
@@ -1865,6 +1939,14 @@ dvi_initialize (void) {
 
   down_ptr = null;
   right_ptr = null;
+  for (k = 0; k < movement_hash_size; k++) {
+	movement_hash[0][k] = null;
+	movement_hash[1][k] = null;
+  }
+  y_here_ptr[0] = y_here_ptr[1] = null;
+  z_here_ptr[0] = z_here_ptr[1] = null;
+  dvi_movements = 0;
+  dvi_movements_reused = 0;
 }
 
 /* module 642 */
@@ -1912,20 +1994,16 @@ finish_dvi_file (void) {
 	dvi_out (post_post);
 	dvi_four (last_bop);
 	dvi_out (id_byte);
-	k = 4 + ((dvi_buf_size - dvi_ptr) % 4); /* the number of 223's */ 
+	k = 4 + ((4 - (dvi_offset + dvi_ptr) % 4) % 4); /* the number of 223's */ 
 	while (k > 0) {
 	  dvi_out (223);
 	  decr (k);
 	};
 	/* begin expansion of Empty the last bytes out of |dvi_buf| */
 	/* module 599 */
-	/* Here is how we clean out the buffer when \TeX\ is all through; |dvi_ptr|
-	 * will be a multiple of~4.
+	/* Here is how we clean out the buffer when \TeX\ is all through.
 	 */
-	if (dvi_limit == half_buf)
-	  write_dvi (half_buf, dvi_buf_size - 1);
-	if (dvi_ptr > 0)
-	  write_dvi (0, dvi_ptr - 1);
+	dvi_flush (true);
 	/* end expansion of Empty the last bytes out of |dvi_buf| */
 	print_nl_string("Output written on ");
 	slow_print (output_file_name);
@@ -1952,12 +2030,11 @@ finish_dvi_file (void) {
 void 
 special_out (pointer p) {
   unsigned char old_setting; /* holds print |selector| */ 
-  pool_pointer k; /* index into |str_pool| */ 
   synch_h;
   synch_v;
   old_setting = selector;
   selector = new_string;
-  show_token_list (link (write_tokens (p)), null, pool_size - pool_ptr);
+  show_token_list (link (write_tokens (p)), null, max_halfword - pool_ptr);
   selector = old_setting;
   str_room (1);
   if (cur_length < 256) {
@@ -1967,8 +2044,7 @@ special_out (pointer p) {
 	dvi_out (xxx4);
 	dvi_four (cur_length);
   };
-  for (k = str_start[str_ptr]; k <= pool_ptr - 1; k++)
-    dvi_out (str_pool[k]);
+  dvi_out_block (&str_pool[str_start[str_ptr]], cur_length);
   pool_ptr = str_start[str_ptr]; /* erase the string */ 
 };
 
@@ -18,6 +18,11 @@ EXTERN void dvi_initialize (void);
 
 /* module 595 */
 EXTERN eight_bits *dvi_buf; /* buffer for \.{DVI} output */
+EXTERN int dvi_ptr; /* the next available buffer address */
+EXTERN int dvi_offset; /* the number of bytes output before |dvi_buf[0]| */
+
+/* module 607 */
+EXTERN integer dvi_movements, dvi_movements_reused; /* for the statistics */
 
 /* module 615 */
 EXTERN void hlist_out (void);
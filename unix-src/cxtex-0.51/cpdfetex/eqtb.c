@@ -58,7 +58,7 @@
  * called |xeq_level|.
  */
 memory_word *eqtb;
-quarterword xeq_level[eqtb_size];
+quarterword xeq_level[eqtb_size+1];
 
 /* module 237 */
 
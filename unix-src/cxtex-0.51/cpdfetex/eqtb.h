@@ -431,7 +431,7 @@
 
 
 EXTERN memory_word *eqtb;
-EXTERN quarterword xeq_level[eqtb_size];
+EXTERN quarterword xeq_level[eqtb_size+1];
 
 
 EXTERN void print_param (int n);
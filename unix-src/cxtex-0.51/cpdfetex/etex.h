@@ -53,6 +53,8 @@ EXTERN void group_trace (boolean e);
 EXTERN void etex_initialize (void) ;
 EXTERN void dump_etex_stuff (void) ;
 
+EXTERN pointer pseudo_files; /* stack of pseudo files */
+
 EXTERN void pseudo_start (void);
 EXTERN boolean pseudo_input (void);
 EXTERN void pseudo_close (void);
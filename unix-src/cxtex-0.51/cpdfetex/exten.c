@@ -629,6 +629,9 @@ do_extension (void) {
 	scan_toks (false, true);
 	pdf_trailer_toks = concat_tokens (pdf_trailer_toks, def_ref);
 	/* end expansion of Implement \.{\\pdftrailer} */
+	break;
+  case save_checkpoint_code:
+	save_checkpoint();
   };
 };
 
@@ -108,6 +108,21 @@ scan_font_ident (void) {
   cur_val = f;
 }
 
+/* |font_info| is only ever addressed by index, so \.{-auto-grow} can
+ * reallocate it when a font does not fit; |font_info_grow| returns |false|
+ * if that is not allowed.
+ */
+boolean
+font_info_grow (integer need) {
+  integer n;
+  n = grow_size (grow_font_info, font_mem_size, need, sup_font_mem_size);
+  if (n == font_mem_size)
+	return false;
+  font_info = xrealloc (font_info, (n + 1) * sizeof (fmemory_word));
+  font_mem_size = n;
+  return true;
+}
+
 /* module 578 */
 
 /* The following routine is used to implement `\.{\\fontdimen} |n| |f|'.
@@ -137,7 +152,7 @@ find_font_dimen (boolean writing) {	/* sets |cur_val| to |font_info| location */
 		/* begin expansion of Increase the number of parameters in the last font */
 		/* module 580 */
 	    do {
-		  if (fmem_ptr == font_mem_size)
+		  if ((fmem_ptr == font_mem_size) && !font_info_grow (fmem_ptr + 1))
 			overflow ("font memory", font_mem_size);
 		  font_info[fmem_ptr].sc = 0;
 		  incr (fmem_ptr);
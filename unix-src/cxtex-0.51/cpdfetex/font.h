@@ -355,6 +355,7 @@ extern integer *param_base; /* base addresses for font parameters */
 extern four_quarters null_character; /* nonexistent character information */
 
 EXTERN void scan_font_ident (void);
+EXTERN boolean font_info_grow (integer need);
 EXTERN void find_font_dimen (boolean writing);
 
 
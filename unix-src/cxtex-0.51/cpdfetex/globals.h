@@ -289,3 +289,6 @@ extern unsigned char k;
 #include "exten.h"
 #include "thread.h"
 #include "pdfproc.h"
+#include "profile.h"
+#include "stats.h"
+#include "checkpoint.h"
@@ -27,6 +27,7 @@ EXTERN boolean global_no_new_control_sequence; /* are new identifiers legal? */
 #define set_no_new_control_sequence(a) global_no_new_control_sequence=a
 
 EXTERN int cs_count; /* total number of known identifiers */
+EXTERN pointer hash_used; /* allocation pointer for |hash| */
 
 EXTERN pointer id_lookup (int j, int l);
 EXTERN pointer id_lookup_string (str_number);
@@ -241,13 +241,13 @@ int threshold; /* maximum badness on feasible lines */
  * keeps track of the smallest value in the |minimal_demerits| array.
  */
 
-integer minimal_demerits[tight_fit]; /* best total demerits known for current
+integer minimal_demerits[tight_fit+1]; /* best total demerits known for current
 										line class and position, given 
 										the fitness */
 integer minimum_demerits; /* best total demerits known for current 
 							 line class and position */
-pointer  best_place[tight_fit]; /* how to achieve |minimal_demerits| */
-halfword best_pl_line[tight_fit]; /* corresponding line number */
+pointer  best_place[tight_fit+1]; /* how to achieve |minimal_demerits| */
+halfword best_pl_line[tight_fit+1]; /* corresponding line number */
 
 /* module 981 */
 #define set_break_width_to_background( arg )  break_width [ arg ]  =  background [ arg ]
@@ -1393,6 +1393,7 @@ line_break (boolean d) {
   small_number j; /* an index into |hc| or |hu| */ 
   unsigned char c; /* character being considered for hyphenation */
   /* end expansion of Local variables for line breaking */
+  stats_enter (stats_line_break);
   pack_begin_line = mode_line;  /* this is for over/underfull box messages */
   /* begin expansion of Get ready to start line breaking */
   /* module 960 */
@@ -2184,6 +2185,7 @@ line_break (boolean d) {
   /* Clean up the memory by removing the break nodes */
   cleanup_memory;
   pack_begin_line = 0;
+  stats_leave;
 };
 
 
@@ -110,7 +110,7 @@ EXTERN int cur_font_step; /* the current step of expanded fonts */
 EXTERN pointer cur_p; /* the current breakpoint under consideration */
 
 /* module 977 */
-EXTERN pointer  best_place[tight_fit]; /* how to achieve |minimal_demerits| */
+EXTERN pointer  best_place[tight_fit+1]; /* how to achieve |minimal_demerits| */
 
 /* module 991 */
 EXTERN halfword last_special_line; /* line numbers |>last_special_line| 
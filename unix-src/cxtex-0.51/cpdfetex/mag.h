@@ -1,4 +1,6 @@
 
+EXTERN integer mag_set; /* if nonzero, this magnification should be used henceforth*/
+
 EXTERN void prepare_mag (void);
 
 EXTERN void mag_initialize(void);
@@ -72,6 +72,8 @@ const_string PDFETEXHELP[] = {
     "",
     "  If no arguments or options are specified, prompt for input.",
     "",
+    "-auto-grow               enlarge the memory arrays when they fill up instead",
+    "                          of stopping",
     "-efm=FMTNAME             use FMTNAME instead of program name or a %& line",
     "-ini                     be pdfeinitex, for dumping formats; this is implicitly",
     "                          true if the program name is `pdfeinitex'",
@@ -79,7 +81,13 @@ const_string PDFETEXHELP[] = {
     "                          scrollmode/errorstopmode)",
     "-jobname=STRING          set the job name to STRING",
     "-mltex                   enable MLTeX extensions such as \\charsubdef",
+    "-pk-cache=DIR            keep the glyphs of PK fonts in DIR for later runs",
+    "-profile-macros=FILE     write a callgrind profile of macro expansion to FILE",
     "-progname=STRING         set program (and fmt) name to STRING",
+    "-resume-from=FILE        continue from a checkpoint saved by \\savecheckpoint",
+    "-ship-thread             compress PDF page contents and font programs in",
+    "                          background threads",
+    "-stats-json=FILE         write per-page timings and memory usage to FILE",
     "-help                    display this help and exit",
     "-version                 output version information and exit",
     NULL
@@ -259,6 +267,12 @@ static struct option long_options[]
       { "mltex",                  0, &mltex_p, 1 },
       { "debug-format",           0, &debug_format_file, 1 },
       { "jobname",                1, 0, 0 },
+      { "ship-thread",            0, &ship_thread_p, 1 },
+      { "auto-grow",              0, &auto_grow_p, 1 },
+      { "pk-cache",               1, 0, 0 },
+      { "profile-macros",         1, 0, 0 },
+      { "stats-json",             1, 0, 0 },
+      { "resume-from",            1, 0, 0 },
       { 0, 0, 0, 0 } };
 
 static void
@@ -304,6 +318,20 @@ parse_options(int argc,  string * argv)
         WARNING1 ("Ignoring unknown argument `%s' to --interaction", optarg);
       }
       
+    } else if (ARGUMENT_IS ("pk-cache")) {
+      pk_cache_dir = optarg;
+
+    } else if (ARGUMENT_IS ("profile-macros")) {
+      profile_macros_file = optarg;
+      profiling_macros = true;
+
+    } else if (ARGUMENT_IS ("resume-from")) {
+      resume_file_name = optarg;
+    } else if (ARGUMENT_IS ("stats-json")) {
+      stats_json_file = optarg;
+      stats_enabled = true;
+      stats_start();
+
     } else if (ARGUMENT_IS ("help")) {
        usagehelp (PROGRAM_HELP);
 
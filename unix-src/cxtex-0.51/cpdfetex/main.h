@@ -5,4 +5,15 @@ EXTERN void         get_date_and_time (integer *,integer *,integer *, integer *)
 EXTERN integer      getrandomseed(void);
 EXTERN void         setup_bound_variable (integer * var,  const_string var_name,  integer dflt);
 
+/* module 241 */
 
+/* The following procedure, which is called just before \TeX\ initializes its
+ * input and output, establishes the initial values of the date and time.
+ * It calls a macro-defined |date_and_time| routine. |date_and_time|
+ * in turn is a C macro, which calls |get_date_and_time|, passing
+ * it the addresses of the day, month, etc., so they can be set by the
+ * routine. |get_date_and_time| also sets up interrupt catching if that
+ * is conditionally compiled in the C code.
+ */
+#define fix_date_and_time  \
+  get_date_and_time (address_of(tex_time), address_of(day), address_of(month), address_of(year))
@@ -14,7 +14,7 @@
  * |null| or a pointer to the reference count of a token list.
  */
 
-pointer cur_mark[split_bot_mark_code]; /* token lists for marks */
+pointer cur_mark[split_bot_mark_code+1]; /* token lists for marks */
 
 /* module 383 */
 void
@@ -141,6 +141,7 @@ do_marks (small_number a, small_number l, pointer q) {
 	}; /* there are no other cases */ 
 	if (sa_bot_mark (q) == null)
 	  if (sa_split_bot_mark (q) == null) {
+		sa_unmap (q);
 		free_node (q, mark_class_node_size);
 		q = null;
 	  };
@@ -24,7 +24,7 @@
 #define split_bot_mark  cur_mark [ split_bot_mark_code ]
 
 
-EXTERN pointer cur_mark[split_bot_mark_code]; /* token lists for marks */
+EXTERN pointer cur_mark[split_bot_mark_code+1]; /* token lists for marks */
 
 EXTERN void mark_initialize (void);
 
@@ -1950,7 +1950,7 @@ mlist_to_hlist (void) {
 	if (r_type > 0)	{ /* not the first noad */
 	  /*switch (so (str_pool[r_type * 8 + t + magic_offset]))*/
 	  char *math_spacing ="0234000122*4000133**3**344*0400400*000000234000111*1111112341011"; 
-	  switch (str_pool[(integer)math_spacing[(r_type-ord_noad)*8-(t-ord_noad)]]) {
+	  switch (math_spacing[(r_type-ord_noad)*8+(t-ord_noad)]) {
 	  case '0':
 		x = 0;
 		break;
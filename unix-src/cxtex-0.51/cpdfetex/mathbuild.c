@@ -344,22 +344,22 @@ init_math (void) {
 	  };
 	  s = mem[p - 1].sc;
 	  l = mem[p].sc;
-	  /* end expansion of Calculate the length, |l|, and the shift amount, |s|, ...*/
-	  push_math (math_shift_group);
-	  mode = mmode;
-	  eq_word_define (int_base + cur_fam_code, -1);
-	  eq_word_define (dimen_base + pre_display_size_code, w);
-	  LR_box = j;
-	  if (eTeX_ex)
-		eq_word_define (int_base + pre_display_direction_code, x);
-	  eq_word_define (dimen_base + display_width_code, l);
-	  eq_word_define (dimen_base + display_indent_code, s);
-	  if (every_display != null)
-		begin_token_list (every_display, every_display_text);
-	  if (nest_ptr == 1)
-		build_page();
-	  /* end expansion of Go into display math mode */
-	}
+	};
+	/* end expansion of Calculate the length, |l|, and the shift amount, |s|, ...*/
+	push_math (math_shift_group);
+	mode = mmode;
+	eq_word_define (int_base + cur_fam_code, -1);
+	eq_word_define (dimen_base + pre_display_size_code, w);
+	LR_box = j;
+	if (eTeX_ex)
+	  eq_word_define (int_base + pre_display_direction_code, x);
+	eq_word_define (dimen_base + display_width_code, l);
+	eq_word_define (dimen_base + display_indent_code, s);
+	if (every_display != null)
+	  begin_token_list (every_display, every_display_text);
+	if (nest_ptr == 1)
+	  build_page();
+	/* end expansion of Go into display math mode */
   } else  {
 	back_input();
 	/* Go into ordinary math mode */
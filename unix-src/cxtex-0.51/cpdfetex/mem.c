@@ -1,4 +1,6 @@
 
+#include <sys/mman.h>
+
 #include "types.h"
 #include "c-compat.h"
 
@@ -63,6 +65,79 @@ memory_word *mem; /* the big dynamic storage area */
 pointer lo_mem_max; /* the largest location of variable-size memory in use */ 
 pointer hi_mem_min; /* the smallest location of one-word memory in use */
 
+/* With \.{-auto-grow}, |mem| is put in a reservation of address space with
+ * room for |sup_main_memory| words in all, the same amount below |mem_min|
+ * as above |mem_max|; pages are only mapped as they are first touched. When
+ * the one-word nodes run out, |mem_max| moves up; when the variable-size
+ * nodes do, |mem_min| moves down and the new words become one free node,
+ * like the extra low memory of a production version. The array never moves,
+ * so statements like `|link(p):=get_avail|' are safe whichever side the C
+ * compiler evaluates first, and a reallocation would not be.
+ */
+static memory_word *mem_region = NULL; /* the reservation, if there is one */
+static size_t mem_region_size; /* its size in bytes */
+
+memory_word *
+mem_alloc (integer lo, integer hi) { /* returns |yzmem| for |mem[lo..hi]| */
+  integer room; /* words of the reservation below |lo|, and above |hi| */
+  void *r;
+  if (auto_grow_p && (hi + 1 - lo < sup_main_memory)) {
+	room = sup_main_memory - (hi + 1 - lo);
+	mem_region_size = ((size_t)(hi + 1 - lo) + 2 * (size_t)room) * sizeof (memory_word);
+	r = mmap (NULL, mem_region_size, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (r != MAP_FAILED) {
+	  mem_region = (memory_word *)r;
+	  return mem_region + room;
+	}
+  }
+  return xmalloc_array (memory_word, hi - lo);
+}
+
+void
+mem_free (void) {
+  if (mem_region != NULL) {
+	munmap (mem_region, mem_region_size);
+	mem_region = NULL;
+  } else {
+	libc_free (yzmem);
+  }
+}
+
+/* Makes |mem| larger by at least |need| words at the top, or at the bottom
+ * if |top| is false; the result tells whether that could be done. Since the
+ * reservation has room for |sup_main_memory| words on either side, the cap
+ * on the total size keeps both ends inside it.
+ */
+static boolean
+mem_grow (boolean top, integer need) {
+  integer n, d; /* the new size, and the growth */
+  pointer p, q, t; /* the old |llink(rover)|, the new free node, its last word */
+  if (mem_region == NULL)
+	return false;
+  n = grow_size (grow_mem, mem_max + 1 - mem_min, mem_max + 1 - mem_min + need, sup_main_memory);
+  d = n - (mem_max + 1 - mem_min);
+  if (d == 0)
+	return false;
+  if (top) {
+	mem_max = mem_max + d;
+  } else {
+	t = (mem_min < mem_bot - 2 ? mem_min : mem_bot - 1);
+	mem_min = mem_min - d;
+	link (mem_min) = null;
+	info (mem_min) = null; /* the bottom word is not used, as in |load_fmt_file| */
+	p = llink (rover);
+	q = mem_min + 1;
+	rlink (p) = q;
+	llink (rover) = q;
+	rlink (q) = rover;
+	llink (q) = p;
+	link (q) = empty_flag;
+	node_size (q) = t + 1 - q;
+  }
+  return true;
+}
+
 
 /* module 117 */
 
@@ -114,10 +189,16 @@ get_avail (void) {	/* single-word node allocation */
 	  decr (hi_mem_min);
 	  p = hi_mem_min;
 	  if (hi_mem_min <= lo_mem_max) {
-		runaway();
-		/* if memory is exhausted, display possible runaway text */
-		overflow ("main memory size", mem_max + 1 - mem_min);
-		/* quit; all one-word nodes are busy */
+		if (mem_grow (true, 1)) { /* take the new word at the top instead */
+		  incr (hi_mem_min);
+		  incr (mem_end);
+		  p = mem_end;
+		} else {
+		  runaway();
+		  /* if memory is exhausted, display possible runaway text */
+		  overflow ("main memory size", mem_max + 1 - mem_min);
+		  /* quit; all one-word nodes are busy */
+		}
 	  };
 	};
   };
@@ -273,6 +354,8 @@ get_node (int s) {	/* variable-size node allocation */
 	  /* end expansion of Grow more variable-size memory and |goto restart| */
 	};
   };
+  if (mem_grow (false, s + 3))
+	goto RESTART;
   overflow ("main memory size", mem_max + 1 - mem_min);
   /* sorry, nothing satisfactory is left */
 FOUND:
@@ -45,6 +45,8 @@ EXTERN pointer avail;
 EXTERN pointer mem_end;
 EXTERN pointer rover;
 
+EXTERN memory_word *mem_alloc (integer lo, integer hi);
+EXTERN void mem_free (void);
 EXTERN pointer get_avail (void);
 EXTERN void flush_list (pointer p);
 EXTERN pointer get_node (int s);
@@ -248,13 +248,19 @@ pdfbasic_initialize (void) {
 
 /* module 652 */
 
-/* We use |pdf_get_mem| to allocate memory in |pdf_mem|
+/* We use |pdf_get_mem| to allocate memory in |pdf_mem|; everybody refers
+ * to |pdf_mem| by index, so \.{-auto-grow} can simply reallocate it.
  */
 integer 
 pdf_get_mem (int s) { /* allocate |s| words in |pdf_mem| */
   integer ret;
-  if (pdf_mem_ptr + s > pdf_mem_size)
-	overflow ("PDF memory size", pdf_mem_size);
+  if (pdf_mem_ptr + s > pdf_mem_size) {
+	ret = grow_size (grow_pdf_mem, pdf_mem_size, pdf_mem_ptr + s, sup_pdf_mem_size);
+	if (ret == pdf_mem_size)
+	  overflow ("PDF memory size", pdf_mem_size);
+	pdf_mem = xrealloc (pdf_mem, (ret + 1) * sizeof (integer));
+	pdf_mem_size = ret;
+  }
   ret = pdf_mem_ptr;
   pdf_mem_ptr = pdf_mem_ptr + s;
   return ret;
@@ -22,6 +22,7 @@ integer pdf_save_offset; /* to save |pdf_offset| */
 integer zip_write_state; /* which state of compression we are in */
 integer fixed_pdf_minor_version; /* fixed minor part of the pdf version */
 boolean  pdf_minor_version_has_been_written; /* flag if the pdf version has been written */
+boolean ship_thread_p; /* compress page streams in a background thread? */
 
 /* module 657 */
 
@@ -69,11 +70,18 @@ pdf_flush (void) { /* flush out the |pdf_buf| */
 	};
 	break;
   case zip_writing:
+	stats_enter (stats_deflate);
 	write_zip (false);
+	stats_leave;
 	break;
   case zip_finish:
+	stats_enter (stats_deflate);
 	write_zip (true);
+	stats_leave;
 	zip_write_state = no_zip;
+	break;
+  case zip_deferred:
+	writezip_defer();
   };
   pdf_ptr = 0;
 };
@@ -111,6 +119,26 @@ pdf_end_stream (void) {	/* end a stream */
   pdf_end_obj();
 }
 
+/* With |ship_thread_p| set, the contents of a page are not compressed
+ * on the fly. |pdf_begin_deferred_stream| makes |pdf_flush| collect them
+ * in memory instead, and |pdf_end_deferred_stream| hands them to the
+ * shipping threads as the contents of object |n|, whose dictionary gets
+ * the entries |dict| (if not |NULL|) besides /Length and /Filter. The
+ * complete object is written out later by |writezip_collect|.
+ */
+void 
+pdf_begin_deferred_stream (void) {
+  pdf_flush();
+  zip_write_state = zip_deferred;
+}
+
+void 
+pdf_end_deferred_stream (integer n, char *dict) {
+  pdf_flush();
+  zip_write_state = no_zip;
+  writezip_submit (n, dict);
+}
+
 void
 remove_last_space (void) {
   if ((pdf_ptr > 0) && (pdf_buf[pdf_ptr - 1] == 32))
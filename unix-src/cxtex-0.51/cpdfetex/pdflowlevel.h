@@ -16,6 +16,7 @@
 #define no_zip 0
 #define zip_writing 1
 #define zip_finish 2
+#define zip_deferred 3 /* collecting a stream for the shipping threads */
 #define pdf_quick_out(arg) { pdf_buf [pdf_ptr] = arg; incr (pdf_ptr); }
 #define pdf_room( arg ) {                              \
    if (  pdf_buf_size  -  arg  < 0  )                  \
@@ -35,6 +36,7 @@ EXTERN integer pdf_save_offset; /* to save |pdf_offset| */
 EXTERN integer zip_write_state; /* which state of compression we are in */
 EXTERN integer fixed_pdf_minor_version; /* fixed minor part of the pdf version */
 EXTERN boolean  pdf_minor_version_has_been_written; /* flag if the pdf version has been written */
+EXTERN boolean ship_thread_p; /* compress page streams and font programs in background threads? */
 
 EXTERN void pdflowlevel_initialize (void);
 
@@ -43,6 +45,8 @@ EXTERN void check_and_set_pdfoptionpdfminorversion (void);
 EXTERN void pdf_flush (void) ;
 EXTERN void pdf_begin_stream (void);
 EXTERN void pdf_end_stream (void);
+EXTERN void pdf_begin_deferred_stream (void);
+EXTERN void pdf_end_deferred_stream (integer n, char *dict);
 
 EXTERN void remove_last_space (void);
 EXTERN void pdf_print_octal (integer n);
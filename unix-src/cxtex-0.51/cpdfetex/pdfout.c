@@ -37,7 +37,7 @@ pdf_out_literal (pointer p) {
   str_number s;
   old_setting = selector;
   selector = new_string;
-  show_token_list (link (pdf_literal_data (p)), null, pool_size - pool_ptr);
+  show_token_list (link (pdf_literal_data (p)), null, max_halfword - pool_ptr);
   selector = old_setting;
   s = make_string();
   if (pdf_literal_direct (p) == 1) {
@@ -54,7 +54,7 @@ pdf_special (pointer p) {
   str_number s;
   old_setting = selector;
   selector = new_string;
-  show_token_list (link (write_tokens (p)), null,pool_size - pool_ptr);
+  show_token_list (link (write_tokens (p)), null, max_halfword - pool_ptr);
   selector = old_setting;
   s = make_string();
   literal (s, true, true, true);
@@ -65,7 +65,7 @@ str_number
 tokens_to_string (pointer p) { /* return a string from tokens list */
   old_setting = selector;
   selector = new_string;
-  show_token_list (link (p), null, pool_size - pool_ptr);
+  show_token_list (link (p), null, max_halfword - pool_ptr);
   selector = old_setting;
   last_tokens_string = make_string();
   return last_tokens_string;
@@ -783,6 +783,7 @@ pdf_ship_out (pointer p, boolean shipping_page) {  /* output the box |p| */
   int save_image_procset; /* to save |pdf_image_procset| */ 
   int save_text_procset; /* to save |pdf_text_procset| */ 
   int pdf_last_resources;  /* pointer to most recently generated Resources object */
+  boolean deferred; /* are the page contents compressed by the shipping thread? */
   /* str_number s;*/
   /*unsigned char old_setting;*/ /* saved |selector| setting */ 
   if (tracing_output > 0) {
@@ -810,7 +811,11 @@ pdf_ship_out (pointer p, boolean shipping_page) {  /* output the box |p| */
 	init_pdf_output = true;
   };
   is_shipping_page = shipping_page;
+  deferred = shipping_page && ship_thread_p && (pdf_compress_level > 0);
   if (shipping_page) {
+	stats_enter (stats_deflate);
+	writezip_collect(); /* write out the contents of the previous page */
+	stats_leave;
 	if (term_offset > (unsigned)max_print_line - 9) {
 	  print_ln();
 	} else if ((term_offset > 0) || (file_offset > 0))
@@ -894,8 +899,12 @@ pdf_ship_out (pointer p, boolean shipping_page) {  /* output the box |p| */
 	/* end expansion of Calculate page dimensions and margins */
 	pdf_last_page = get_obj (obj_type_page, total_pages + 1, 0);
 	obj_aux (pdf_last_page) = 1; /* mark that this page has beed created */
-	pdf_new_dict (obj_type_others, 0);
-	pdf_last_stream = obj_ptr;
+	if (deferred) {
+	  pdf_last_stream = pdf_new_objnum();
+	} else {
+	  pdf_new_dict (obj_type_others, 0);
+	  pdf_last_stream = obj_ptr;
+	}
 	cur_h = cur_h_offset;
 	cur_v = height (p) + cur_v_offset;
 	pdf_origin_h = 0;
@@ -935,7 +944,10 @@ pdf_ship_out (pointer p, boolean shipping_page) {  /* output the box |p| */
 
   /* begin expansion of Start stream of page/form contents */
   /* module 730 */
-  pdf_begin_stream();
+  if (deferred) {
+	pdf_begin_deferred_stream();
+  } else
+	pdf_begin_stream();
   if (shipping_page) {
 	/* begin expansion of Adjust tranformation matrix for the
 	   magnification ratio */
@@ -963,7 +975,10 @@ pdf_ship_out (pointer p, boolean shipping_page) {  /* output the box |p| */
   /* begin expansion of Finish stream of page/form contents */
   /* module 734 */
   pdf_end_text();
-  pdf_end_stream();
+  if (deferred) {
+	pdf_end_deferred_stream (pdf_last_stream, NULL);
+  } else
+	pdf_end_stream();
   /* end expansion of Finish stream of page/form contents */
   if (shipping_page) {
 	/* begin expansion of Write out page object */
@@ -1431,6 +1446,7 @@ flush_whatsit_node (pointer p, small_number s) {
 /* module 750 */
 void 
 pdf_write_image (int n) { /* write an image */
+  stats_enter (stats_images);
   pdf_begin_dict (n);
   if (obj_ximage_attr (n) != null) {
 	pdf_print_toks_ln (obj_ximage_attr (n));
@@ -1438,6 +1454,7 @@ pdf_write_image (int n) { /* write an image */
   };
   write_image (obj_ximage_data (n));
   delete_image (obj_ximage_data (n));
+  stats_leave;
 }
 
 /* module 758 */
@@ -1465,11 +1482,15 @@ void ship_out (pointer p) {	/* output the box |p| */
 	if (fixed_output != pdf_output)
 	  pdf_error_string("setup","\\pdfoutput cannot be changed after shipping out the first page");
   };
+  if (stats_enabled)
+	stats_ship_begin();
   if (pdf_output > 0) {
 	pdf_ship_out (p, true);
   } else {
 	dvi_ship_out (p);
   }
+  if (stats_enabled)
+	stats_ship_end();
 }
 
 /* module 766 */
@@ -1579,7 +1600,6 @@ pdf_print_info (void) { /* print info object */
 	  pdf_print_nl;
 	};
 	flush_str (ss);
-	free(s);
 	delete_toks (pdf_info_toks);
   };
   if (!creator_given)
@@ -1613,6 +1633,9 @@ finish_pdf_file (void) {
 	print_nl_string("No pages of output.");
   } else {
 	pdf_flush(); /* to make sure that the output file name has been already created */
+	stats_enter (stats_deflate);
+	writezip_collect(); /* contents of the last page(s) from the shipping thread */
+	stats_leave;
 	if (total_pages % pages_tree_kids_max != 0)
 	  obj_info (pdf_last_pages) = total_pages % pages_tree_kids_max;
 	/* last pages object may have less than |pages_tree_kids_max| chilrend */
@@ -1675,9 +1698,15 @@ finish_pdf_file (void) {
 	k = head_tab[obj_type_font];
 	while (k != 0) {
 	  f = obj_info (k);
+	  stats_enter (stats_fonts);
 	  do_pdf_font (k, f);
+	  stats_leave;
+	  incr (stats_fonts_embedded);
 	  k = obj_link (k);
 	};
+	stats_enter (stats_deflate);
+	writezip_collect(); /* font programs from the shipping threads */
+	stats_leave;
 	/* end expansion of Output fonts definition */
 	/* begin expansion of Output pages tree */
 	/* module 773 */
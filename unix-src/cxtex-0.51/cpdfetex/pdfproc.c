@@ -219,9 +219,11 @@ scan_image (void) {
 	zprint (')');
 	print_ln();
   };
+  stats_enter (stats_images);
   obj_ximage_data (k) = read_image (s, page, named,pdf_option_pdf_minor_version,
 									pdf_option_always_use_pdfpagebox, 
 									pdf_option_pdf_inclusion_errorlevel);
+  stats_leave;
   if (named != 0)
 	flush_str (named);
   flush_str (s);
@@ -360,12 +360,172 @@ static void copyFontDict(Object *obj, InObj *r)
     pdf_puts(">>");
 }
 
+// The stream is read in blocks straight into the free part of pdfbuf;
+// for a raw FileStream these are plain fread()s of the source file.
 static void copyStream(Stream *str)
 {
-    int c;
+    int n;
     str->reset();
-    while ((c = str->getChar()) != EOF)
-        pdfout(c);
+    do {
+        if (pdfptr + 1 >= pdf_buf_size)
+            pdfflush();
+        n = str->getBlock((char *) pdfbuf + pdfptr, pdf_buf_size - 1 - pdfptr);
+        pdfptr += n;
+    } while (n > 0);
+}
+
+// A part of a page's /Contents array, see copyFlateContents
+struct FlatePart {
+    Object obj;         // the content stream
+    BaseStream *base;   // its undecoded data
+    FlateExtent ext;    // where the deflate data lie in base
+    Guint adler;        // Adler-32 checksum of the decoded data
+};
+
+static void putByte(int c)
+{
+    if (pdfptr + 1 >= pdf_buf_size)
+        pdfflush();
+    pdfbuf[pdfptr++] = c;
+}
+
+// Copy the bytes from position from up to position to of str
+static void copyBytes(Stream *str, Guint from, Guint to)
+{
+    int n;
+    str->setPos(from);
+    while (from < to) {
+        if (pdfptr + 1 >= pdf_buf_size)
+            pdfflush();
+        n = pdf_buf_size - 1 - pdfptr;
+        if ((Guint) n > to - from)
+            n = to - from;
+        if ((n = str->getBlock((char *) pdfbuf + pdfptr, n)) == 0)
+            pdftex_fail("pdf inclusion: unexpected end of stream");
+        pdfptr += n;
+        from += n;
+    }
+}
+
+// The checksum of two pieces of data, from those of the pieces and the
+// length len2 of the second one (as adler32_combine() in newer zlibs)
+static Guint combineAdler(Guint adler1, Guint adler2, Guint len2)
+{
+    const Guint base = 65521;
+    Guint sum1, sum2, rem;
+    rem = len2 % base;
+    sum1 = adler1 & 0xffff;
+    sum2 = (rem * sum1) % base;
+    sum1 += (adler2 & 0xffff) + base - 1;
+    sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + base - rem;
+    if (sum1 >= base)
+        sum1 -= base;
+    if (sum1 >= base)
+        sum1 -= base;
+    if (sum2 >= 2 * base)
+        sum2 -= 2 * base;
+    if (sum2 >= base)
+        sum2 -= base;
+    return sum1 | (sum2 << 16);
+}
+
+static GBool isFlateOnly(Object *obj)
+{
+    PdfObject filter, name;
+    if (!obj->isStream() || obj->getStream()->getKind() != strFlate)
+        return gFalse;
+    obj->streamGetDict()->lookup((char *)"Filter", &filter);
+    if (filter->isArray() && filter->arrayGetLength() == 1)
+        filter->arrayGet(0, &name);
+    else
+        filter->copy(&name);
+    return name->isName((char *)"FlateDecode");
+}
+
+// When all parts of a /Contents array are plain FlateDecode streams,
+// their deflate data are joined into one stream instead of being
+// inflated and deflated again.  The final-block flag of each part but
+// the last is cleared, and an empty stored block brings the next part
+// to a byte boundary; the checksum is combined from those of the parts.
+// Returns false, having written nothing, if that is not possible.
+static GBool copyFlateContents(Object *contents)
+{
+    FlatePart *parts, *p;
+    Guint adler, length;
+    int i, l, k, c;
+    GBool ok;
+    l = contents->arrayGetLength();
+    if (zgetintpar(cfg_compress_level_code) <= 0 || l == 0)
+        return gFalse;
+    parts = new FlatePart[l];
+    ok = gTrue;
+    for (i = 0; i < l; ++i) {
+        p = &parts[i];
+        contents->arrayGet(i, &p->obj);
+        if (!ok)
+            continue;
+        if (!isFlateOnly(&p->obj) ||
+            !((FlateStream *) p->obj.getStream())->skim(&p->ext)) {
+            ok = gFalse;
+            continue;
+        }
+        // the zlib trailer follows the deflate data
+        p->base = p->obj.getStream()->getBaseStream();
+        p->base->setPos(p->ext.endPos + (p->ext.endBit > 0));
+        for (p->adler = 0, k = 0; k < 4; ++k) {
+            if ((c = p->base->getChar()) == EOF)
+                ok = gFalse;
+            p->adler = (p->adler << 8) | (c & 0xff);
+        }
+    }
+    if (ok) {
+        adler = parts[0].adler;
+        length = 2 + 4;
+        for (i = 0; i < l; ++i) {
+            p = &parts[i];
+            if (i > 0)
+                adler = combineAdler(adler, p->adler, p->ext.length);
+            length += p->ext.endPos + (p->ext.endBit > 0) -
+                      (p->base->getStart() + 2);
+            if (i < l - 1 && p->ext.endBit > 0)
+                length += (p->ext.endBit > 5) + 4;
+        }
+        pdf_printf("/Length %i\n/Filter /FlateDecode\n>>\nstream\n",
+                   (int) length);
+        putByte(0x78);
+        putByte(0x9c);
+        for (i = 0; i < l; ++i) {
+            p = &parts[i];
+            if (i < l - 1) {
+                copyBytes(p->base, p->base->getStart() + 2,
+                          p->ext.lastBlockPos);
+                c = p->base->getChar();
+                putByte(c & ~(1 << p->ext.lastBlockBit));
+                copyBytes(p->base, p->ext.lastBlockPos + 1, p->ext.endPos);
+            } else
+                copyBytes(p->base, p->base->getStart() + 2, p->ext.endPos);
+            if (p->ext.endBit > 0) {
+                c = p->base->getChar();
+                putByte(c & ((1 << p->ext.endBit) - 1));
+                if (i < l - 1) {
+                    if (p->ext.endBit > 5)
+                        putByte(0);
+                    putByte(0);
+                    putByte(0);
+                    putByte(0xff);
+                    putByte(0xff);
+                }
+            }
+        }
+        for (k = 24; k >= 0; k -= 8)
+            putByte((adler >> k) & 0xff);
+        pdf_puts("\nendstream\n");
+        pdfendobj();
+    }
+    for (i = 0; i < l; ++i)
+        parts[i].obj.free();
+    delete[] parts;
+    return ok;
 }
 
 static void copyProcSet(Object *obj)
@@ -1030,13 +1190,15 @@ write_epdf(void)
         pdfendobj();
     }
     else if (contents->isArray()) {
-        pdfbeginstream();
-        for (i = 0, l = contents->arrayGetLength(); i < l; ++i) {
-        Object contentsobj;
-            copyStream((contents->arrayGet(i, &contentsobj))->getStream());
-        contentsobj.free();
+        if (!copyFlateContents(&contents)) {
+            pdfbeginstream();
+            for (i = 0, l = contents->arrayGetLength(); i < l; ++i) {
+            Object contentsobj;
+                copyStream((contents->arrayGet(i, &contentsobj))->getStream());
+            contentsobj.free();
+            }
+            pdfendstream();
         }
-        pdfendstream();
     }
     else {// the contents are optional, but we need to include an empty stream
         pdfbeginstream();
@@ -172,6 +172,8 @@ extern void poppacketstate(void);
 extern void pushpacketstate(void);
 extern void startpacket(internal_font_number, integer);
 extern void storepacket(integer, integer, integer);
+extern vf_instruction *packetcode(internal_font_number, integer);
+extern void storepacketcode(internal_font_number, integer, vf_instruction *);
 extern void vf_free(void);
 
 /* writeenc.c */
@@ -212,6 +214,7 @@ extern void load_enc(char *, char **);
 extern void writet1(void);
 
 /* writet3.c */
+extern char *pk_cache_dir;
 extern void writet3(int, internal_font_number);
 extern scaled getpkcharwidth(internal_font_number, scaled);
 
@@ -221,5 +224,8 @@ extern void writeotf(void);
 
 /* writezip.c */
 extern void writezip(boolean);
+extern void writezip_defer(void);
+extern void writezip_submit(integer, char *);
+extern void writezip_collect(void);
 
 #endif  /* PDFTEXLIB */
@@ -160,7 +160,7 @@ str_number maketexstring(const char *s)
     if (s == 0 || *s == 0)
         return get_nullstr();
     l = strlen(s);
-    check_buf(pool_ptr + l, pool_size);
+    str_room(l);
     while (l-- > 0)
         str_pool[pool_ptr++] = *s++;
     last_tex_string = make_string();
@@ -455,6 +455,7 @@ void printID (str_number filename)
     char id[64];
     char *file_name;
     char pwd[4096];
+    int i;
     /* start md5 */
     md5_init(&state);
     /* get the time */
@@ -469,8 +470,12 @@ void printID (str_number filename)
     md5_append(&state, (const md5_byte_t *)file_name, strlen(file_name));
     /* finish md5 */
     md5_finish(&state, digest);
-    /* write the IDs */
-    convertStringToHexString ((char*)digest, id);
+    /* write the IDs; the digest is binary and may contain zeros, so it
+       cannot go through convertStringToHexString */
+    id[0] = '<';
+    for (i = 0; i < 16; i++)
+        sprintf (id + 1 + 2 * i, "%02X", (unsigned int)digest[i]);
+    strcpy (id + 33, ">");
     pdf_printf("/ID [%s %s]\n", id, id);
 }
 
@@ -34,6 +34,7 @@ static int packet_max;
 typedef struct {
     char **data;
     int *len;
+    vf_instruction **code;      /* the compiled packets, see vf.c */
     internal_font_number font;
 }  vf_entry;
 
@@ -49,9 +50,11 @@ integer newvfpacket(internal_font_number f)
     entry_room(vf, 1, 256);
     vf_ptr->len = xtalloc(n, int);
     vf_ptr->data = xtalloc(n, char *);
+    vf_ptr->code = xtalloc(n, vf_instruction *);
     for (i = 0; i < n; i++) {
         vf_ptr->data[i] = 0;
         vf_ptr->len[i] = 0;
+        vf_ptr->code[i] = 0;
     }
     vf_ptr->font = f;
     return vf_ptr++ - vf_tab;
@@ -66,6 +69,16 @@ void storepacket(integer f, integer c, integer s)
            (void *)(str_pool + str_start[s]), (unsigned)l);
 }
 
+vf_instruction *packetcode(internal_font_number f, integer c)
+{
+    return vf_tab[vfpacketbase[f]].code[c - font_bc[f]];
+}
+
+void storepacketcode(internal_font_number f, integer c, vf_instruction *code)
+{
+    vf_tab[vfpacketbase[f]].code[c - font_bc[f]] = code;
+}
+
 void pushpacketstate()
 {
     entry_room(packet, 1, 256);
@@ -102,6 +115,7 @@ void vf_free(void)
     vf_entry *v;
     int n;
     char **p;
+    vf_instruction **q, *i;
     if (vf_tab != 0) {
         for (v = vf_tab; v < vf_ptr; v++) {
             xfree(v->len);
@@ -109,6 +123,14 @@ void vf_free(void)
             for (p = v->data; p - v->data < n ; p++)
                 xfree(*p);
             xfree(v->data);
+            for (q = v->code; q - v->code < n ; q++) {
+                if (*q == 0)
+                    continue;
+                for (i = *q; i->op != vf_op_end; i++)
+                    xfree(i->s);
+                xfree(*q);
+            }
+            xfree(v->code);
         }
         xfree(vf_tab);
     }
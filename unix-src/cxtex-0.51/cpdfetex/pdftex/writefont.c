@@ -212,6 +212,7 @@ static void write_fontobj(integer font_objnum)
 static void write_fontfile(void)
 {
     int i;
+    char dict[128];
     for (i = 0; i < FONT_KEYS_NUM; i++)
         font_keys[i].valid = false;
     fontfile_found = false;
@@ -225,14 +226,22 @@ static void write_fontfile(void)
     if (fm_cur->ff_objnum == 0)
         pdftex_fail("font file object number for `%s' not initialized",
                     fm_cur->tfm_name);
-    pdf_begin_dict(fm_cur->ff_objnum); /* font file stream */
     if (is_truetype(fm_cur))
-        pdf_printf("/Length1 %i\n", (int)ttf_length);
+        sprintf(dict, "/Length1 %i\n", (int)ttf_length);
     else if (is_otf_font) 
-        pdf_printf("/Subtype /Type1C\n");
+        sprintf(dict, "/Subtype /Type1C\n");
     else
-        pdf_printf("/Length1 %i\n/Length2 %i\n/Length3 %i\n",
-                   (int)t1_length1, (int)t1_length2, (int)t1_length3);
+        sprintf(dict, "/Length1 %i\n/Length2 %i\n/Length3 %i\n",
+                (int)t1_length1, (int)t1_length2, (int)t1_length3);
+    if (ship_thread_p && pdf_compress_level > 0) {
+        /* deflated by the shipping threads, see writezip.c */
+        pdf_begin_deferred_stream();
+        ff_flush();
+        pdf_end_deferred_stream(fm_cur->ff_objnum, dict);
+        return;
+    }
+    pdf_begin_dict(fm_cur->ff_objnum); /* font file stream */
+    pdf_puts(dict);
     pdfbeginstream();
     ff_flush();
     pdfendstream();
@@ -23,6 +23,8 @@ $Id: writet3.c,v 1.2 2004/05/11 14:30:32 taco Exp $
 #include "ptexlib.h"
 #include <kpathsea/tex-glyph.h>
 #include <kpathsea/magstep.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define T3_BUF_SIZE   1024
 
@@ -176,15 +178,265 @@ scaled getpkcharwidth(internal_font_number f, scaled w)
            pdffontsize[f];
 }
 
+/* The glyphs of a PK file.
+
+   Unpacking the run-length encoded rasters of a PK file is most of the
+   work for a bitmap font, and what comes out depends on the PK file only:
+   the bounding box of each glyph and the part of its CharProc after the
+   |d1| line.  So |writepk| first collects these for every glyph of the
+   file, in file order, and then writes the CharProcs of the marked ones.
+
+   With \.{-pk-cache=DIR} the collected glyphs are also saved in DIR, one
+   file per PK file, and later runs read them from there instead of
+   unpacking the PK file again; other documents using the same bitmap font
+   at the same resolution share the file.  A cache file starts with the
+   path, size and modification time of its PK file and the resolution
+   asked for, and it is only used when all of them still match.  The widths
+   are not cached, they come from the TFM file of the font being written.
+*/
+
+typedef struct {
+    integer charcode;
+    integer llx, lly, urx, ury;
+    integer len;                /* length of the CharProc data, or -1 for
+                                   a glyph without pixels */
+    integer data;               /* offset of the data in |pk_data| */
+} pk_glyph_entry;
+
+static pk_glyph_entry *pk_glyph_ptr, *pk_glyph_tab = 0;
+static int pk_glyph_max;
+
+static char *pk_data = 0;
+static integer pk_data_len, pk_data_max;
+
+char *pk_cache_dir = 0;
+
+#define PK_CACHE_MAGIC  "%PDFTEX-PK-CACHE 1\n"
+
+static char *pk_data_room(integer n)
+{
+    if (pk_data == 0) {
+        pk_data_max = n > 0x10000 ? n : 0x10000;
+        pk_data = xtalloc(pk_data_max, char);
+    }
+    else if (pk_data_len + n > pk_data_max) {
+        pk_data_max = pk_data_len + n > 2*pk_data_max ?
+            pk_data_len + n : 2*pk_data_max;
+        xretalloc(pk_data, pk_data_max, char);
+    }
+    return pk_data + pk_data_len;
+}
+
+static void pk_put_int(FILE *f, integer i)
+{
+    putc((i >> 24) & 0xff, f);
+    putc((i >> 16) & 0xff, f);
+    putc((i >> 8) & 0xff, f);
+    putc(i & 0xff, f);
+}
+
+static integer pk_get_int(unsigned char **p)
+{
+    integer i = ((*p)[0] << 24) | ((*p)[1] << 16) | ((*p)[2] << 8) | (*p)[3];
+    *p += 4;
+    return i;
+}
+
+static char *pk_cache_name(char *pk_name)
+{
+    char buf[32];
+    unsigned long h = 5381;
+    char *p, *name;
+    for (p = pk_name; *p != 0; p++)
+        h = (h*33) ^ (unsigned char)*p;
+    sprintf(buf, "-%08lx.t3c", h & 0xffffffffUL);
+    p = concat(xbasename(pk_name), buf);
+    name = concat3(pk_cache_dir, DIR_SEP_STRING, p);
+    xfree(p);
+    return name;
+}
+
+/* the identity of a PK file as stored in the header of its cache file */
+static char *pk_cache_header(char *pk_name, integer dpi)
+{
+    struct stat st;
+    char buf[64];
+    if (stat(pk_name, &st) != 0)
+        return 0;
+    sprintf(buf, "\n%ld %ld %i\n", (long)st.st_size, (long)st.st_mtime,
+            (int)dpi);
+    return concat3(PK_CACHE_MAGIC, pk_name, buf);
+}
+
+static boolean pk_cache_read(char *pk_name, integer dpi)
+{
+    char *name, *header;
+    unsigned char *p, *q, *data_end;
+    FILE *f;
+    long size;
+    integer n, len;
+    boolean ok = false;
+    if (pk_cache_dir == 0 || (header = pk_cache_header(pk_name, dpi)) == 0)
+        return false;
+    name = pk_cache_name(pk_name);
+    f = fopen(name, FOPEN_RBIN_MODE);
+    xfree(name);
+    if (f == 0) {
+        xfree(header);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    pk_data_len = 0;
+    p = (unsigned char *)pk_data_room(size);
+    if (size < (long)strlen(header) + 4 ||
+        fread(p, 1, (size_t)size, f) != (size_t)size ||
+        memcmp(p, header, strlen(header)) != 0)
+        goto done;
+    data_end = p + size;
+    q = p + strlen(header);
+    n = pk_get_int(&q);
+    pk_glyph_ptr = pk_glyph_tab;
+    while (n-- > 0) {
+        if (data_end - q < 24)
+            goto done;
+        entry_room(pk_glyph, 1, 256);
+        pk_glyph_ptr->charcode = pk_get_int(&q);
+        pk_glyph_ptr->llx = pk_get_int(&q);
+        pk_glyph_ptr->lly = pk_get_int(&q);
+        pk_glyph_ptr->urx = pk_get_int(&q);
+        pk_glyph_ptr->ury = pk_get_int(&q);
+        pk_glyph_ptr->len = len = pk_get_int(&q);
+        pk_glyph_ptr->data = q - p;
+        if (pk_glyph_ptr->charcode < 0 ||
+            pk_glyph_ptr->charcode > MAX_CHAR_CODE ||
+            len < -1 || len > data_end - q)
+            goto done;
+        if (len > 0)
+            q += len;
+        pk_glyph_ptr++;
+    }
+    ok = (q == data_end);
+    pk_data_len = size;
+done:
+    fclose(f);
+    xfree(header);
+    if (!ok) {
+        pk_glyph_ptr = pk_glyph_tab;
+        pk_data_len = 0;
+    }
+    return ok;
+}
+
+static void pk_cache_write(char *pk_name, integer dpi)
+{
+    char *name, *tmp_name, *header;
+    char buf[32];
+    pk_glyph_entry *g;
+    FILE *f;
+    if ((header = pk_cache_header(pk_name, dpi)) == 0)
+        return;
+    name = pk_cache_name(pk_name);
+    /* other runs may be reading the cache, so it is replaced in one go */
+    sprintf(buf, ".%ld", (long)getpid());
+    tmp_name = concat(name, buf);
+    if ((f = fopen(tmp_name, FOPEN_W_MODE)) == 0) {
+        pdftex_warn("cannot write PK cache file `%s'", tmp_name);
+        goto done;
+    }
+    fputs(header, f);
+    pk_put_int(f, pk_glyph_ptr - pk_glyph_tab);
+    for (g = pk_glyph_tab; g < pk_glyph_ptr; g++) {
+        pk_put_int(f, g->charcode);
+        pk_put_int(f, g->llx);
+        pk_put_int(f, g->lly);
+        pk_put_int(f, g->urx);
+        pk_put_int(f, g->ury);
+        pk_put_int(f, g->len);
+        if (g->len > 0)
+            fwrite(pk_data + g->data, 1, (size_t)g->len, f);
+    }
+    if (fclose(f) != 0 || rename(tmp_name, name) != 0) {
+        pdftex_warn("cannot write PK cache file `%s'", name);
+        remove(tmp_name);
+    }
+done:
+    xfree(tmp_name);
+    xfree(name);
+    xfree(header);
+}
+
+/* Unpack the glyphs of the PK file |pk_name|; without a cache only the
+   marked ones need their CharProc data. */
+static void pk_read_glyphs(internal_font_number f, char *pk_name)
+{
+    chardesc cd;
+    integer cw, rw, i, j;
+    halfword *row;
+    char *p;
+    boolean check_preamble = true;
+    t3_file = xfopen(pk_name, FOPEN_RBIN_MODE);
+    pk_glyph_ptr = pk_glyph_tab;
+    pk_data_len = 0;
+    cd.rastersize = 256;
+    cd.raster = xtalloc(cd.rastersize, halfword);
+    while (readchar(check_preamble, &cd) != 0) {
+        check_preamble = false;
+        entry_room(pk_glyph, 1, 256);
+        pk_glyph_ptr->charcode = cd.charcode;
+        pk_glyph_ptr->len = -1;
+        pk_glyph_ptr->data = 0;
+        if (cd.cwidth < 1 || cd.cheight < 1) {
+            pk_glyph_ptr++;
+            continue;
+        }
+        pk_glyph_ptr->llx = -cd.xoff;
+        pk_glyph_ptr->lly = cd.yoff - cd.cheight + 1;
+        pk_glyph_ptr->urx = cd.cwidth + pk_glyph_ptr->llx + 1;
+        pk_glyph_ptr->ury = cd.cheight + pk_glyph_ptr->lly;
+        if (pk_cache_dir == 0 && !pdfcharmarked(f, cd.charcode)) {
+            pk_glyph_ptr++;
+            continue;
+        }
+        cw = (cd.cwidth + 7)/8;
+        rw = (cd.cwidth + 15)/16;
+        p = pk_data_room(256 + cd.cheight*cw);
+        p += sprintf(p, "q\n%i 0 0 %i %i %i cm\nBI\n", (int)cd.cwidth,
+                     (int)cd.cheight, (int)pk_glyph_ptr->llx,
+                     (int)pk_glyph_ptr->lly);
+        p += sprintf(p, "/W %i\n/H %i\n", 
+                     (int)cd.cwidth, (int)cd.cheight);
+        p += sprintf(p, "/IM true\n/BPC 1\n/D [1 0]\nID ");
+        row = cd.raster;
+        for (i = 0; i < cd.cheight; i++) {
+            for (j = 0; j < rw - 1; j++) {
+                *p++ = *row/256;
+                *p++ = *row%256;
+                row++;
+            }
+            *p++ = *row/256;
+            if (2*rw == cw)
+                *p++ = *row%256;
+            row++;
+        }
+        p += sprintf(p, "\nEI\nQ\n");
+        pk_glyph_ptr->data = pk_data_len;
+        pk_glyph_ptr->len = p - (pk_data + pk_data_len);
+        pk_data_len += pk_glyph_ptr->len;
+        pk_glyph_ptr++;
+    }
+    xfree(cd.raster);
+    xfclose(t3_file, pk_name);
+}
+
 static boolean writepk(internal_font_number f)
 {
     kpse_glyph_file_type font_ret;
     integer llx, lly, urx, ury;
-    integer cw, rw, i, j;
-    halfword *row;
+    integer cw, i;
     char *name;
-    chardesc cd;
-    boolean is_null_glyph;
+    pk_glyph_entry *g;
     integer dpi;
     int e;
     dpi = kpse_magstep_fix(
@@ -204,64 +456,44 @@ static boolean writepk(internal_font_number f)
         cur_file_name = 0;
         return false;
     }
-    t3_file = xfopen(name, FOPEN_RBIN_MODE);
     t3_image_used = true;
     is_pk_font = true;
     tex_printf(" <%s", (char *)name);
-    cd.rastersize = 256;
-    cd.raster = xtalloc(cd.rastersize, halfword);
-    while (readchar((t3_glyph_num == 0), &cd) != 0) {
+    if (!pk_cache_read(name, dpi)) {
+        pk_read_glyphs(f, name);
+        if (pk_cache_dir != 0)
+            pk_cache_write(name, dpi);
+    }
+    for (g = pk_glyph_tab; g < pk_glyph_ptr; g++) {
         t3_glyph_num++;
-        if (!pdfcharmarked(f, cd.charcode))
+        if (!pdfcharmarked(f, g->charcode))
             continue;
-        t3_char_widths[cd.charcode] = 
-            pk_char_width(f, get_char_width(f, cd.charcode));
-        if (cd.cwidth < 1 || cd.cheight < 1) {
-            cd.xescape = cd.cwidth = round(t3_char_widths[cd.charcode]/100.0);
-            cd.cheight = 1;
-            cd.xoff = 0;
-            cd.yoff = 0;
-            is_null_glyph = true;
+        t3_char_widths[g->charcode] = 
+            pk_char_width(f, get_char_width(f, g->charcode));
+        if (g->len < 0) {
+            cw = round(t3_char_widths[g->charcode]/100.0);
+            llx = 0;
+            lly = 0;
+            urx = cw + 1;
+            ury = 1;
+        }
+        else {
+            llx = g->llx;
+            lly = g->lly;
+            urx = g->urx;
+            ury = g->ury;
         }
-        else
-            is_null_glyph = false;
-        llx = -cd.xoff;
-        lly = cd.yoff - cd.cheight + 1;
-        urx = cd.cwidth + llx + 1;
-        ury = cd.cheight + lly;
         update_bbox(llx, lly, urx, ury);
         pdf_new_dict(0, 0);
-        t3_char_procs[cd.charcode] = obj_ptr;
+        t3_char_procs[g->charcode] = obj_ptr;
         pdfbeginstream();
-        pdf_print_real(t3_char_widths[cd.charcode], 2);
+        pdf_print_real(t3_char_widths[g->charcode], 2);
         pdf_printf(" 0 %i %i %i %i d1\n", 
                     (int)llx, (int)lly, (int)urx, (int)ury);
-        if (is_null_glyph)
-            goto end_stream;
-        pdf_printf("q\n%i 0 0 %i %i %i cm\nBI\n", (int)cd.cwidth,
-                   (int)cd.cheight, (int)llx, (int)lly);
-        pdf_printf("/W %i\n/H %i\n", 
-                   (int)cd.cwidth, (int)cd.cheight);
-        pdf_puts("/IM true\n/BPC 1\n/D [1 0]\nID ");
-        cw = (cd.cwidth + 7)/8;
-        rw = (cd.cwidth + 15)/16;
-        row = cd.raster;
-        for (i = 0; i < cd.cheight; i++) {
-            for (j = 0; j < rw - 1; j++) {
-                pdfout(*row/256);
-                pdfout(*row%256);
-                row++;
-            }
-            pdfout(*row/256);
-            if (2*rw == cw)
-                pdfout(*row%256);
-            row++;
-        }
-        pdf_puts("\nEI\nQ\n");
-end_stream:
+        for (i = 0; i < g->len; i++)
+            pdfout(pk_data[g->data + i]);
         pdfendstream();
     }
-    xfree(cd.raster);
     cur_file_name = 0;
     return true;
 }
@@ -389,7 +621,8 @@ write_font_dict:
         if (t3_char_procs[i] != 0)
             pdf_printf("/a%i %i 0 R\n", (int)i, (int)t3_char_procs[i]);
     pdfenddict();
-    t3_close();
+    if (!is_pk_font)
+        t3_close();
     tex_printf(">");
     cur_file_name = 0;
 }
@@ -22,6 +22,8 @@ $Id: writezip.c,v 1.2 2004/05/11 14:30:32 taco Exp $
 
 #include "ptexlib.h"
 #include "zlib.h"
+#include <pthread.h>
+#include <unistd.h>
 
 static const char perforce_id[] = 
     "$Id: writezip.c,v 1.2 2004/05/11 14:30:32 taco Exp $";
@@ -81,3 +83,149 @@ void writezip(boolean finish)
     }
     pdfstreamlength = c_stream.total_out;
 }
+
+/* Deferred page streams.  With -ship-thread the uncompressed contents of a
+   page are collected in memory while the page is shipped out; the buffer is
+   then handed to a background thread that deflates it, and the main thread
+   goes on typesetting.  The compressed stream is written out as a complete
+   object the next time writezip_collect() is called, which happens at
+   fixed points (beginning of the next page, end of the document), so the
+   output file does not depend on thread timing.
+
+   The font programs written by writefont.c go the same way, so that at the
+   end of the document the programs of all fonts are deflated by a few
+   threads at once while the main thread goes on subsetting the next font.
+   Their dictionaries have more entries than /Length and /Filter, which are
+   kept with the job. */
+
+typedef struct zip_job {
+    integer objnum;             /* object number of the stream */
+    int level;                  /* compression level */
+    Bytef *in;                  /* uncompressed contents */
+    uLong in_len, in_max;
+    Bytef *out;                 /* deflated contents */
+    uLongf out_len;
+    char *dict;                 /* more entries of the stream dictionary */
+    int err;
+    boolean done;
+    struct zip_job *next;
+} zip_job;
+
+#define ZIP_THREADS_MAX 8
+
+static zip_job *zip_first = NULL, *zip_last = NULL; /* submitted, in order */
+static zip_job *zip_todo = NULL;   /* first job not yet taken by the thread */
+static zip_job *zip_cur = NULL;    /* job being collected */
+static int zip_thread_num = 0;
+static pthread_t zip_threads[ZIP_THREADS_MAX];
+static pthread_mutex_t zip_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t zip_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t zip_done = PTHREAD_COND_INITIALIZER;
+
+static void *zip_thread_main(void *arg)
+{
+    zip_job *j;
+    (void) arg;
+    for (;;) {
+        pthread_mutex_lock(&zip_mutex);
+        while (zip_todo == NULL)
+            pthread_cond_wait(&zip_work, &zip_mutex);
+        j = zip_todo;
+        zip_todo = j->next;
+        pthread_mutex_unlock(&zip_mutex);
+        j->out_len = j->in_len + j->in_len / 1000 + 13;
+        j->out = xtalloc(j->out_len, Bytef);
+        j->err = compress2(j->out, &j->out_len, j->in, j->in_len, j->level);
+        xfree(j->in);
+        pthread_mutex_lock(&zip_mutex);
+        j->done = true;
+        pthread_cond_broadcast(&zip_done);
+        pthread_mutex_unlock(&zip_mutex);
+    }
+    return NULL;
+}
+
+void writezip_defer(void)
+{
+    if (zip_cur == NULL) {
+        zip_cur = xtalloc(1, zip_job);
+        memset(zip_cur, 0, sizeof(zip_job));
+        zip_cur->in_max = ZIP_BUF_SIZE;
+        zip_cur->in = xtalloc(zip_cur->in_max, Bytef);
+    }
+    if (zip_cur->in_len + pdfptr > zip_cur->in_max) {
+        while (zip_cur->in_len + pdfptr > zip_cur->in_max)
+            zip_cur->in_max *= 2;
+        xretalloc(zip_cur->in, zip_cur->in_max, Bytef);
+    }
+    memcpy(zip_cur->in + zip_cur->in_len, pdfbuf, pdfptr);
+    zip_cur->in_len += pdfptr;
+}
+
+static void zip_start_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+        n = 1;
+    else if (n > ZIP_THREADS_MAX)
+        n = ZIP_THREADS_MAX;
+    for (; zip_thread_num < n; zip_thread_num++)
+        if (pthread_create(&zip_threads[zip_thread_num], NULL,
+                           zip_thread_main, NULL) != 0) {
+            if (zip_thread_num == 0)
+                pdftex_fail("cannot start the page shipping thread");
+            break;
+        }
+}
+
+void writezip_submit(integer objnum, char *dict)
+{
+    zip_job *j;
+    if (zip_cur == NULL)
+        writezip_defer();   /* empty stream */
+    j = zip_cur;
+    zip_cur = NULL;
+    j->objnum = objnum;
+    j->level = fixedcompresslevel;
+    j->dict = dict != NULL ? xstrdup(dict) : NULL;
+    if (zip_thread_num == 0)
+        zip_start_threads();
+    pthread_mutex_lock(&zip_mutex);
+    if (zip_last == NULL)
+        zip_first = j;
+    else
+        zip_last->next = j;
+    zip_last = j;
+    if (zip_todo == NULL)
+        zip_todo = j;
+    pthread_cond_signal(&zip_work);
+    pthread_mutex_unlock(&zip_mutex);
+}
+
+void writezip_collect(void)
+{
+    zip_job *j;
+    while (zip_first != NULL) {
+        j = zip_first;
+        pthread_mutex_lock(&zip_mutex);
+        while (!j->done)
+            pthread_cond_wait(&zip_done, &zip_mutex);
+        zip_first = j->next;
+        if (zip_first == NULL)
+            zip_last = NULL;
+        pthread_mutex_unlock(&zip_mutex);
+        check_err(j->err, "compress2");
+        pdf_begin_dict(j->objnum);
+        if (j->dict != NULL) {
+            pdf_puts(j->dict);
+            xfree(j->dict);
+        }
+        pdf_printf("/Length %i\n/Filter /FlateDecode\n>>\nstream\n",
+                   (int)j->out_len);
+        pdfflush();
+        pdfgone += xfwrite(j->out, 1, j->out_len, pdffile);
+        pdf_puts("endstream\nendobj\n");
+        xfree(j->out);
+        xfree(j);
+    }
+}
@@ -36,8 +36,14 @@ pdfxref_initialize (void) {
  */
 void
 append_dest_name (str_number s, integer n) {
-  if (pdf_dest_names_ptr == dest_names_size)
-    overflow ("number of destination names", dest_names_size);
+  integer k;
+  if (pdf_dest_names_ptr == dest_names_size) {
+    k = grow_size (grow_dest_names, dest_names_size, dest_names_size + 1, sup_dest_names_size);
+    if (k == dest_names_size)
+      overflow ("number of destination names", dest_names_size);
+    dest_names = xrealloc (dest_names, (k + 1) * sizeof (dest_name_entry));
+    dest_names_size = k;
+  }
   dest_names[pdf_dest_names_ptr].objname = s;
   dest_names[pdf_dest_names_ptr].objnum = n;
   incr (pdf_dest_names_ptr);
@@ -48,8 +54,13 @@ void
 pdf_create_obj (integer t, integer i) {
   /* create an object with type |t| and identifier |i| */
   integer p, q;
-  if (obj_ptr == obj_tab_size)
-    overflow ("indirect objects table size", obj_tab_size);
+  if (obj_ptr == obj_tab_size) {
+    p = grow_size (grow_obj_tab, obj_tab_size, obj_tab_size + 1, sup_obj_tab_size);
+    if (p == obj_tab_size)
+      overflow ("indirect objects table size", obj_tab_size);
+    obj_tab = xrealloc (obj_tab, (p + 1) * sizeof (obj_entry));
+    obj_tab_size = p;
+  }
   incr (obj_ptr);
   obj_info (obj_ptr) = i;
   obj_offset (obj_ptr) = 0;
@@ -94,12 +94,12 @@ print_visible_char (ASCII_code s) {	/* prints a single character */
 	if (tally < trick_count)
 	  trick_buf[tally % error_line] = s;
 	break;
-  case new_string:
-	if (pool_ptr < pool_size)
-	  append_char (s);
+  case new_string: /* the pool grows as needed, see |str_pool_grow| */
+	str_room (1);
+	append_char (s);
 	break;
   default:
-	fprintf (write_file[selector], "%c", Xchr(s));
+	putc (Xchr(s), write_file[selector]);
   };
   incr (tally);
 };
@@ -156,9 +156,74 @@ print_char (ASCII_code s) {	/* prints a single character */
   }
 };
 
+/* Most of what goes to the terminal and the log consists of characters
+ * that |print_char| hands unchanged to |print_visible_char|. |print_run|
+ * prints such a run of |n| characters in one go: it is cut where a line
+ * has to be broken, and each piece is written with a single |fwrite| per
+ * destination. The output is the same as that of |n| calls of
+ * |print_char|.
+ */
+#define bulk_selector ((selector >= term_only) && (selector <= term_and_log))
+
+#define plain_char( arg ) (((arg) != new_line_char) && isprint (Xchr(arg)))
+
+static void
+print_run (ASCII_code *s, int n) {
+  char buf[256];
+  int room, m, k;
+  while (n > 0) {
+	room = max_print_line;
+	if (selector != log_only)
+	  room = max_print_line - (int)term_offset;
+	if ((selector != term_only) && (max_print_line - (int)file_offset < room))
+	  room = max_print_line - (int)file_offset;
+	if (room <= 0) { /* a line that is already too long never breaks */
+	  print_visible_char (*s);
+	  s++;
+	  n--;
+	  continue;
+	}
+	m = (n < room ? n : room);
+	if (m > (int)sizeof (buf))
+	  m = sizeof (buf);
+	for (k = 0; k < m; k++)
+	  buf[k] = Xchr(s[k]);
+	if (selector != log_only) {
+	  fwrite (buf, 1, m, term_out);
+	  term_offset += m;
+	  if (term_offset == (unsigned)max_print_line) {
+		wterm_cr;
+		term_offset = 0;
+	  };
+	}
+	if (selector != term_only) {
+	  fwrite (buf, 1, m, log_file);
+	  file_offset += m;
+	  if (file_offset == (unsigned)max_print_line) {
+		wlog_cr;
+		file_offset = 0;
+	  };
+	}
+	tally += m;
+	s += m;
+	n -= m;
+  }
+}
+
 void
 zprint_string (char *s) {/* prints string |s| */
+  ASCII_code run[256];
+  int n;
   while (*s) {
+	if (bulk_selector) {
+	  n = 0;
+	  while (*s && (n < 256) && plain_char (str_pool[(integer)*s]))
+		run[n++] = str_pool[(integer)*s++];
+	  if (n > 0) {
+		print_run (run, n);
+		continue;
+	  }
+	}
     print_char (str_pool[(integer)*s]);
 	s++;
   };
@@ -198,6 +263,16 @@ zprint (int s) { /* prints string |s| */
   };
   j = str_start[s];
   while (j < str_start[s + 1]) {
+	if (bulk_selector) {
+	  pool_pointer r = j;
+	  while ((r < str_start[s + 1]) && plain_char (str_pool[r]))
+		incr (r);
+	  if (r > j) {
+		print_run (&str_pool[j], r - j);
+		j = r;
+		continue;
+	  }
+	}
 	print_char (str_pool[j]);
 	incr (j);
   };
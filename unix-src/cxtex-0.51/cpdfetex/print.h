@@ -79,8 +79,8 @@ EXTERN integer max_print_line;
 #define wterm_string(arg)  fprintf ( term_out , "%s", arg )
 #define wlog_string(arg)  fprintf ( log_file , "%s", arg )
 
-#define wterm_char(arg)  fprintf ( term_out , "%c", arg )
-#define wlog_char(arg)  fprintf ( log_file , "%c", arg )
+#define wterm_char(arg)  putc ( arg , term_out )
+#define wlog_char(arg)  putc ( arg , log_file )
 
 #define wterm_cr  fprintf ( term_out , "\n")
 #define wlog_cr  fprintf ( log_file , "\n")
@@ -0,0 +1,358 @@
+
+#include <time.h>
+
+#include "types.h"
+#include "c-compat.h"
+#include "globals.h"
+#include "mainio.h"
+
+/* The macro profiler.
+ *
+ * When \.{--profile-macros=FILE} is given, every expansion of a user macro
+ * is timed from the moment |macro_call| puts its body on the input stack
+ * until |end_token_list| removes that level again. Two costs are kept: the
+ * elapsed time in nanoseconds, and the number of tokens that |get_next|
+ * read from token lists in the meantime. Whatever is spent in macros
+ * called from the body is charged to those macros as well, so each
+ * macro gets an inclusive and an exclusive figure.
+ *
+ * Costs are collected per call site, i.e., per calling macro (zero at the
+ * outer level), called macro, and the file and line that were being read
+ * when the call happened. Since |macro_call| removes exhausted token lists
+ * before it feeds a new body, a macro that ends with a call to another
+ * one appears as a call from its own caller, just as \TeX\ sees it.
+ * At the end of the job the sites are written out in the format of
+ * valgrind's callgrind tool, so that the usual viewers (kcachegrind,
+ * callgrind_annotate) can be used to find the hot spots of a macro
+ * package.
+ */
+
+const_string profile_macros_file = NULL;
+boolean profiling_macros = false;
+
+typedef unsigned long long prof_cost;
+
+/* Pseudo file names for input that does not come from a file */
+#define prof_terminal 0
+#define prof_read_file (-1)
+#define prof_pseudo_file (-2)
+
+typedef struct {
+  pointer callee; /* |eqtb| location of the macro */
+  pointer caller; /* location of the macro that called it, or 0 */
+  str_number file; /* the file being read at the call, or a pseudo name */
+  integer line; /* the line in that file */
+  integer calls;
+  prof_cost self_time, self_tokens; /* exclusive costs */
+  prof_cost incl_time, incl_tokens; /* inclusive costs */
+} prof_site;
+
+typedef struct {
+  integer site; /* index into |prof_sites| */
+  prof_cost start_time, child_time, child_tokens;
+  unsigned int start_tokens;
+} prof_frame;
+
+static prof_site *prof_sites = NULL;
+static integer prof_sites_ptr = 0;
+static integer prof_sites_size = 0;
+
+static integer *prof_hash = NULL; /* site indices, or $-1$ if empty */
+static unsigned int prof_hash_size = 0; /* always a power of two */
+
+static prof_frame *prof_stack = NULL; /* one entry per active macro level */
+static integer prof_ptr = 0;
+
+/* The counters of |get_next| wrap around, so only differences are used */
+#define prof_tokens() ((unsigned int)state_toklist_csname + (unsigned int)state_toklist_normal)
+
+static prof_cost
+prof_now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (prof_cost)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static unsigned int
+prof_hash_code (pointer callee, pointer caller, str_number file, integer l) {
+  unsigned int h;
+  h = (unsigned int)callee * 0x9E3779B1u;
+  h = (h ^ (unsigned int)caller) * 0x9E3779B1u;
+  h = (h ^ (unsigned int)file) * 0x9E3779B1u;
+  h = (h ^ (unsigned int)l) * 0x9E3779B1u;
+  return h ^ (h >> 15);
+}
+
+static void
+prof_rehash (void) {
+  unsigned int h;
+  integer k;
+  free (prof_hash);
+  prof_hash_size = (prof_hash_size == 0 ? 1024 : 2 * prof_hash_size);
+  prof_hash = xmalloc_array (integer, prof_hash_size);
+  for (h = 0; h < prof_hash_size; h++)
+	prof_hash[h] = -1;
+  for (k = 0; k < prof_sites_ptr; k++) {
+	h = prof_hash_code (prof_sites[k].callee, prof_sites[k].caller,
+						prof_sites[k].file, prof_sites[k].line) & (prof_hash_size - 1);
+	while (prof_hash[h] >= 0)
+	  h = (h + 1) & (prof_hash_size - 1);
+	prof_hash[h] = k;
+  }
+}
+
+/* Find the site for a call, creating it if this is the first one */
+static integer
+prof_site_lookup (pointer callee, pointer caller, str_number file, integer l) {
+  unsigned int h;
+  integer k;
+  prof_site *s;
+  if (2 * (unsigned int)prof_sites_ptr >= prof_hash_size)
+	prof_rehash();
+  h = prof_hash_code (callee, caller, file, l) & (prof_hash_size - 1);
+  while ((k = prof_hash[h]) >= 0) {
+	s = &prof_sites[k];
+	if (s->callee == callee && s->caller == caller && s->file == file && s->line == l)
+	  return k;
+	h = (h + 1) & (prof_hash_size - 1);
+  }
+  if (prof_sites_ptr == prof_sites_size) {
+	prof_sites_size = (prof_sites_size == 0 ? 512 : 2 * prof_sites_size);
+	prof_sites = xrealloc (prof_sites, prof_sites_size * sizeof (prof_site));
+  }
+  k = prof_sites_ptr++;
+  s = &prof_sites[k];
+  memset (s, 0, sizeof (prof_site));
+  s->callee = callee;
+  s->caller = caller;
+  s->file = file;
+  s->line = l;
+  prof_hash[h] = k;
+  return k;
+}
+
+/* The position of a call is that of the innermost level that is not a
+ * token list. Its |name| tells whether it is a real file (|name>19|),
+ * a \.{\\scantokens} pseudo file (18 or 19), a \.{\\read} (1--17), or
+ * the terminal (0).
+ */
+static void
+prof_location (str_number *f, integer *l) {
+  in_state_record *p;
+  unsigned int k;
+  p = &cur_input;
+  k = input_ptr;
+  while (p->state_field == token_list && k > 0) {
+	decr (k);
+	p = &input_stack[k];
+  }
+  *l = line;
+  if (p->name_field > 19) {
+	*f = full_source_filename_stack[in_open];
+  } else if (p->name_field >= 18) {
+	*f = prof_pseudo_file;
+  } else if (p->name_field > 0) {
+	*f = prof_read_file;
+  } else {
+	*f = prof_terminal;
+	*l = 0;
+  }
+}
+
+/* Called by |macro_call| once the body of |cs| is on the input stack */
+void
+profile_macro_enter (pointer cs) {
+  prof_frame *fr;
+  str_number f;
+  integer l;
+  if (prof_stack == NULL)
+	prof_stack = xmalloc_array (prof_frame, stack_size);
+  prof_location (&f, &l);
+  fr = &prof_stack[prof_ptr];
+  fr->site = prof_site_lookup (cs, (prof_ptr > 0 ? prof_sites[prof_stack[prof_ptr - 1].site].callee : 0), f, l);
+  incr (prof_sites[fr->site].calls);
+  incr (prof_ptr);
+  fr->child_time = 0;
+  fr->child_tokens = 0;
+  fr->start_tokens = prof_tokens();
+  fr->start_time = prof_now();
+}
+
+/* Called by |end_token_list| when a macro level goes away */
+void
+profile_macro_leave (void) {
+  prof_cost t, dt, dk;
+  prof_frame *fr;
+  prof_site *s;
+  t = prof_now();
+  if (prof_ptr == 0)
+	return;
+  decr (prof_ptr);
+  fr = &prof_stack[prof_ptr];
+  dt = t - fr->start_time;
+  dk = (unsigned int)(prof_tokens() - fr->start_tokens);
+  s = &prof_sites[fr->site];
+  s->incl_time += dt;
+  s->incl_tokens += dk;
+  s->self_time += dt - fr->child_time;
+  s->self_tokens += dk - fr->child_tokens;
+  if (prof_ptr > 0) {
+	prof_stack[prof_ptr - 1].child_time += dt;
+	prof_stack[prof_ptr - 1].child_tokens += dk;
+  }
+}
+
+/* Writing the profile */
+
+static void
+prof_put_char (FILE *f, int c) {
+  if (c < ' ' || c > '~') {
+	fprintf (f, "^^%02x", c);
+  } else {
+	putc (c, f);
+  }
+}
+
+static void
+prof_put_str (FILE *f, str_number s) {
+  pool_pointer k;
+  for (k = str_start[s]; k < str_start[s + 1]; k++)
+	prof_put_char (f, str_pool[k]);
+}
+
+/* Mirrors |sprint_cs|, but without the need for a |selector| */
+static void
+prof_put_cs (FILE *f, pointer p) {
+  if (p == 0) {
+	fputs ("(top level)", f);
+  } else if (p < single_base) {
+	prof_put_char (f, p - active_base);
+  } else if (p < null_cs) {
+	putc ('\\', f);
+	prof_put_char (f, p - single_base);
+  } else if (p < hash_base) {
+	fputs ("\\csname\\endcsname", f);
+  } else {
+	putc ('\\', f);
+	prof_put_str (f, text (p));
+  }
+  putc ('\n', f);
+}
+
+static void
+prof_put_file (FILE *f, str_number s) {
+  if (s == prof_terminal) {
+	fputs ("(terminal)", f);
+  } else if (s == prof_read_file) {
+	fputs ("(\\read)", f);
+  } else if (s == prof_pseudo_file) {
+	fputs ("(\\scantokens)", f);
+  } else {
+	prof_put_str (f, s);
+  }
+  putc ('\n', f);
+}
+
+static int
+prof_by_callee (const void *a, const void *b) {
+  const prof_site *x = &prof_sites[*(const integer *)a];
+  const prof_site *y = &prof_sites[*(const integer *)b];
+  if (x->callee != y->callee)
+	return x->callee < y->callee ? -1 : 1;
+  if (x->file != y->file)
+	return x->file < y->file ? -1 : 1;
+  if (x->line != y->line)
+	return x->line < y->line ? -1 : 1;
+  return x->caller < y->caller ? -1 : (x->caller > y->caller);
+}
+
+static int
+prof_by_caller (const void *a, const void *b) {
+  const prof_site *x = &prof_sites[*(const integer *)a];
+  const prof_site *y = &prof_sites[*(const integer *)b];
+  if (x->caller != y->caller)
+	return x->caller < y->caller ? -1 : 1;
+  if (x->file != y->file)
+	return x->file < y->file ? -1 : 1;
+  if (x->line != y->line)
+	return x->line < y->line ? -1 : 1;
+  return x->callee < y->callee ? -1 : (x->callee > y->callee);
+}
+
+/* Each macro becomes a callgrind function. Its own cost lines come from
+ * the sites where it is the callee, its call lines from the sites where
+ * it is the caller; both are sorted by macro, so they can be merged.
+ */
+void
+profile_macros_write (void) {
+  FILE *f;
+  integer *by_callee, *by_caller;
+  integer i, j, k;
+  pointer fn;
+  str_number cur_file;
+  prof_cost total_time, total_tokens;
+  prof_site *s;
+  while (prof_ptr > 0) /* the job may end inside a macro */
+	profile_macro_leave();
+  f = fopen (profile_macros_file, FOPEN_W_MODE);
+  if (f == NULL) {
+	WARNING1 ("Could not write the macro profile to `%s'", profile_macros_file);
+	return;
+  }
+  by_callee = xmalloc_array (integer, prof_sites_ptr);
+  by_caller = xmalloc_array (integer, prof_sites_ptr);
+  total_time = 0;
+  total_tokens = 0;
+  for (k = 0; k < prof_sites_ptr; k++) {
+	by_callee[k] = k;
+	by_caller[k] = k;
+	total_time += prof_sites[k].self_time;
+	total_tokens += prof_sites[k].self_tokens;
+  }
+  qsort (by_callee, prof_sites_ptr, sizeof (integer), prof_by_callee);
+  qsort (by_caller, prof_sites_ptr, sizeof (integer), prof_by_caller);
+  fprintf (f, "# callgrind format\nversion: 1\ncreator: pdfeTeX macro profiler\n");
+  fprintf (f, "positions: line\nevents: Time Tokens\n");
+  fprintf (f, "event: Time : Elapsed time (ns)\nevent: Tokens : Tokens read from token lists\n");
+  i = 0;
+  j = 0;
+  while (i < prof_sites_ptr || j < prof_sites_ptr) {
+	if (j >= prof_sites_ptr
+		|| (i < prof_sites_ptr && prof_sites[by_callee[i]].callee <= prof_sites[by_caller[j]].caller)) {
+	  fn = prof_sites[by_callee[i]].callee;
+	  cur_file = prof_sites[by_callee[i]].file;
+	} else {
+	  fn = prof_sites[by_caller[j]].caller;
+	  cur_file = prof_sites[by_caller[j]].file;
+	}
+	fputs ("\nfl=", f);
+	prof_put_file (f, cur_file);
+	fputs ("fn=", f);
+	prof_put_cs (f, fn);
+	for (; i < prof_sites_ptr && (s = &prof_sites[by_callee[i]])->callee == fn; i++) {
+	  if (s->file != cur_file) {
+		cur_file = s->file;
+		fputs ("fi=", f);
+		prof_put_file (f, cur_file);
+	  }
+	  fprintf (f, "%ld %llu %llu\n", (long)s->line, s->self_time, s->self_tokens);
+	}
+	for (; j < prof_sites_ptr && (s = &prof_sites[by_caller[j]])->caller == fn; j++) {
+	  if (s->file != cur_file) {
+		cur_file = s->file;
+		fputs ("fi=", f);
+		prof_put_file (f, cur_file);
+	  }
+	  fputs ("cfi=", f);
+	  prof_put_file (f, s->file);
+	  fputs ("cfn=", f);
+	  prof_put_cs (f, s->callee);
+	  fprintf (f, "calls=%ld %ld\n", (long)s->calls, (long)s->line);
+	  fprintf (f, "%ld %llu %llu\n", (long)s->line, s->incl_time, s->incl_tokens);
+	}
+  }
+  fprintf (f, "\ntotals: %llu %llu\n", total_time, total_tokens);
+  fclose (f);
+  free (by_callee);
+  free (by_caller);
+}
@@ -0,0 +1,16 @@
+
+/* The macro profiler, see profile.c */
+
+EXTERN const_string profile_macros_file; /* name given to \.{--profile-macros}, or |NULL| */
+EXTERN boolean profiling_macros; /* is the profiler active? */
+
+EXTERN void profile_macro_enter (pointer cs);
+EXTERN void profile_macro_leave (void);
+EXTERN void profile_macros_write (void);
+
+/* These are the hooks in |macro_call| and |end_token_list|; they cost
+ * only a test of |profiling_macros| when the profiler is off.
+ */
+#define profile_enter(a) { if (profiling_macros) profile_macro_enter(a); }
+#define profile_leave    { if (profiling_macros) profile_macro_leave(); }
+
@@ -88,12 +88,82 @@ new_index (quarterword i, pointer q) {
 #define hex_dig3( arg ) (( arg   / 16 )  % 16)
 #define hex_dig4( arg ) ( arg   % 16)
 
+/* Following the tree costs four dependent loads and, for a new element,
+ * up to four |new_index| nodes. Macro packages that allocate thousands
+ * of registers look them up all the time, so the elements that have been
+ * found or created once are also entered in |sa_map|, which maps a type
+ * and a number directly to the node: 256 pages of 256 pointers per type,
+ * a page being allocated when it gets its first entry. The tree stays
+ * the real representation (the format file, |do_marks| and
+ * |print_sa_num| depend on it) and the map is only a cache: an element
+ * node is removed from the map before it is freed, and the whole map is
+ * cleared when |mem| is reloaded from a format or checkpoint file.
+ */
+static pointer *sa_map[mark_val + 1][256];
+
+static void
+sa_map_element (small_number t, halfword n, pointer p) {
+  pointer *page;
+  int k;
+  page = sa_map[t][n / 256];
+  if (page == NULL) {
+	page = xmalloc_array (pointer, 255);
+	for (k = 0; k <= 255; k++)
+	  page[k] = null;
+	sa_map[t][n / 256] = page;
+  }
+  page[n % 256] = p;
+}
+
+/* The number of the element at |q|, found by walking up the tree. */
+static halfword
+sa_number (pointer q) {
+  halfword n;
+  if (sa_index (q) < dimen_val_limit) {
+	n = sa_num (q);	  /* the easy case */
+  } else {
+	n = hex_dig4 (sa_index (q));
+	q = link (q);
+	n = n + 16 * sa_index (q);
+	q = link (q);
+	n = n + 256 * (sa_index (q) + 16 * sa_index (link (q)));
+  };
+  return n;
+}
+
+/* Removes the element node |q| from |sa_map|; it is about to be freed. */
+void
+sa_unmap (pointer q) {
+  halfword n;
+  pointer *page;
+  n = sa_number (q);
+  page = sa_map[sa_type (q)][n / 256];
+  if (page != NULL)
+	page[n % 256] = null;
+}
+
+void
+sa_clear_map (void) {
+  int t, k;
+  for (t = 0; t <= mark_val; t++)
+	for (k = 0; k <= 255; k++)
+	  if (sa_map[t][k] != NULL) {
+		free (sa_map[t][k]);
+		sa_map[t][k] = NULL;
+	  }
+}
+
 
 void
 find_sa_element (small_number t, halfword n, boolean w) {
   /* sets |cur_val| to sparse array element location or |null| */
   pointer q; /* for list manipulations */ 
   small_number i; /* a four bit index */ 
+  if (sa_map[t][n / 256] != NULL) {
+	cur_ptr = sa_map[t][n / 256][n % 256];
+	if (cur_ptr != null)
+	  return;
+  }
   cur_ptr = sa_root[t];
   if_cur_ptr_is_null_then_return_or_goto (NOT_FOUND);
   q = cur_ptr;
@@ -114,7 +184,8 @@ find_sa_element (small_number t, halfword n, boolean w) {
   if ((cur_ptr == null) && w) {
     goto NOT_FOUND4;
   }
-  do_something;
+  if (cur_ptr != null)
+	sa_map_element (t, n, cur_ptr);
   return;
 NOT_FOUND:
   new_index (t, null); /* create first level index node */ 
@@ -181,6 +252,7 @@ NOT_FOUND4:
   /* end expansion of Create a new array element of type |t| with index |i| */
   link (cur_ptr) = q;
   add_sa_ptr;
+  sa_map_element (t, n, cur_ptr);
 };
 
 
@@ -222,6 +294,7 @@ delete_sa_ref (pointer q) {	/* reduce reference count */
 	  s = pointer_node_size;
 	};
   };
+  sa_unmap (q);
   do {
 	i = hex_dig4 (sa_index (q));
 	p = q;
@@ -245,17 +318,7 @@ delete_sa_ref (pointer q) {	/* reduce reference count */
 
 void
 print_sa_num (pointer q) { /* print register number */
-  halfword n;			/* the register number */
-  if (sa_index (q) < dimen_val_limit) {
-	n = sa_num (q);	  /* the easy case */
-  } else {
-	n = hex_dig4 (sa_index (q));
-	q = link (q);
-	n = n + 16 * sa_index (q);
-	q = link (q);
-	n = n + 256 * (sa_index (q) + 16 * sa_index (link (q)));
-  };
-  print_int (n);
+  print_int (sa_number (q));
 };
 
 /* module 1768 */
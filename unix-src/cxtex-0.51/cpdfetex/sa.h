@@ -57,6 +57,8 @@
 /* module 1761 */
 EXTERN pointer sa_root[(mark_val+1)]; /* roots of sparse arrays */
 EXTERN pointer cur_ptr; /* value returned by |new_index| and |find_sa_element| */
+EXTERN pointer sa_chain; /* chain of saved sparse array entries */
+EXTERN quarterword sa_level; /* group level for |sa_chain| */
 
 EXTERN void sa_initialize(void);
 EXTERN void sa_initialize_init(void);
@@ -72,6 +74,8 @@ EXTERN void gsa_w_def (pointer p, int w);
 EXTERN void sa_restore (pointer, pointer);
 EXTERN void find_sa_element (small_number t, halfword n, boolean w);
 EXTERN void print_sa_num (pointer q);
+EXTERN void sa_unmap (pointer q);
+EXTERN void sa_clear_map (void);
 
 #define sa_define(a,b)             if (e) {\
                                      if (global) { gsa_def (a,b); }\
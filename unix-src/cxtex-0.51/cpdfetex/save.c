@@ -203,6 +203,7 @@ eq_define (pointer p, quarterword t, halfword e) { /* new data for |eqtb| */
   eq_level (p) = cur_level;
   eq_type (p) = t;
   equiv (p) = e;
+  cat_code_changed (p);
   ASSIGN_TRACE (p, "into");
 };
 
@@ -243,6 +244,7 @@ geq_define (pointer p, quarterword t, halfword e) {	/* global |eq_define| */
   eq_level (p) = level_one;
   eq_type (p) = t;
   equiv (p) = e;
+  cat_code_changed (p);
   ASSIGN_TRACE (p, "into");
 };
 
@@ -343,6 +345,7 @@ unsave (void) { 	/* pops the top level off the save stack */
 		  } else {
 		    eq_destroy (eqtb[p]);	/* destroy the current value */
 		    eqtb[p] = save_stack[save_ptr];	/* restore the saved value */
+			cat_code_changed (p);
 			RESTORE_TRACE (p, "restoring");
 		  }
 		} else if (xeq_level[p] != level_one) {
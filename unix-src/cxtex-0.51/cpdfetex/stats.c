@@ -0,0 +1,269 @@
+
+#include <time.h>
+
+#include "types.h"
+#include "c-compat.h"
+#include "globals.h"
+#include "mainio.h"
+
+/* Run statistics.
+ *
+ * With \.{--stats-json=FILE} the run is divided into the phases listed in
+ * stats.h. The hooks keep a small stack of phases, and the clock is always
+ * charged to the phase on top, so a deflate inside |ship_out| counts as
+ * deflate only. Whenever a page is shipped out, the time spent in every
+ * phase since the previous page is recorded, together with the memory in
+ * use as |ship_out| starts: |var_used| and |dyn_used| (the figures behind
+ * \.{\\tracingstats}), |str_ptr|, |pool_ptr| and |obj_ptr|. At the end of
+ * the job the pages, the totals, the peaks of those five values, and the
+ * number of fonts and images loaded are written out as one JSON object.
+ * In \.{DVI} mode each page also gets the number of bytes it took and the
+ * number of movements made, and of those reused through |w0|..|z0|.
+ * Last come the arrays that \.{-auto-grow} can enlarge: for each, its size
+ * at the end, the most of it that was used, and how often it grew from
+ * what size.
+ */
+
+typedef unsigned long long stats_time; /* nanoseconds */
+
+typedef struct {
+  integer page; /* |total_pages| after this page */
+  integer count0; /* \.{\\count0} as the page was shipped */
+  stats_time time[stats_phases];
+  integer var_used, dyn_used, str_used, pool_used, obj_used;
+  integer dvi_bytes, dvi_movements, dvi_reused;
+} stats_page;
+
+#define stats_stack_size 16
+
+const_string stats_json_file = NULL;
+boolean stats_enabled = false;
+integer stats_fonts_embedded = 0;
+
+static const char *stats_phase_name[stats_phases] = {
+  "main_control", "line_break", "build_page", "ship_out",
+  "deflate", "images", "fonts"
+};
+
+static stats_time stats_acc[stats_phases]; /* totals since the start */
+static stats_time stats_mark[stats_phases]; /* |stats_acc| after the previous page */
+static int stats_stack[stats_stack_size]; /* the interrupted phases */
+static int stats_ptr = 0;
+static int stats_cur = stats_main_control; /* the phase being charged */
+static stats_time stats_last; /* when |stats_cur| was last charged */
+
+static stats_page *stats_pages = NULL;
+static integer stats_pages_ptr = 0;
+static integer stats_pages_size = 0;
+static stats_page stats_peak; /* only the memory fields are used */
+static stats_page stats_dvi_mark; /* the \.{DVI} figures after the previous page */
+
+static const char *stats_array_name[grow_arrays] = {
+  "mem", "str_pool", "str_start", "font_info", "trie", "pdf_mem", "obj_tab", "dest_names"
+};
+
+static stats_time
+stats_now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (stats_time)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Called as soon as the option has been seen */
+void
+stats_start (void) {
+  stats_last = stats_now();
+}
+
+static void
+stats_charge (void) {
+  stats_time t = stats_now();
+  stats_acc[stats_cur] += t - stats_last;
+  stats_last = t;
+}
+
+void
+stats_phase_enter (int phase) {
+  stats_charge();
+  if (stats_ptr == stats_stack_size)
+	confusion ("stats");
+  stats_stack[stats_ptr++] = stats_cur;
+  stats_cur = phase;
+}
+
+void
+stats_phase_leave (void) {
+  stats_charge();
+  if (stats_ptr > 0)
+	stats_cur = stats_stack[--stats_ptr];
+}
+
+static void
+stats_sample_memory (stats_page *p) {
+  p->var_used = var_used;
+  p->dyn_used = dyn_used;
+  p->str_used = str_ptr;
+  p->pool_used = pool_ptr;
+  p->obj_used = obj_ptr;
+  if (p->var_used > stats_peak.var_used) stats_peak.var_used = p->var_used;
+  if (p->dyn_used > stats_peak.dyn_used) stats_peak.dyn_used = p->dyn_used;
+  if (p->str_used > stats_peak.str_used) stats_peak.str_used = p->str_used;
+  if (p->pool_used > stats_peak.pool_used) stats_peak.pool_used = p->pool_used;
+  if (p->obj_used > stats_peak.obj_used) stats_peak.obj_used = p->obj_used;
+}
+
+/* |ship_out| brackets the shipping of a page with these two; the memory
+ * is sampled before the box is flushed, when it is at its largest.
+ */
+void
+stats_ship_begin (void) {
+  if (stats_pages_ptr == stats_pages_size) {
+	stats_pages_size = (stats_pages_size == 0 ? 64 : 2 * stats_pages_size);
+	stats_pages = xrealloc (stats_pages, stats_pages_size * sizeof (stats_page));
+  }
+  stats_sample_memory (&stats_pages[stats_pages_ptr]);
+  stats_pages[stats_pages_ptr].count0 = count (0);
+  stats_phase_enter (stats_ship_out);
+}
+
+void
+stats_ship_end (void) {
+  stats_page *p;
+  int k;
+  stats_phase_leave();
+  p = &stats_pages[stats_pages_ptr++];
+  p->page = total_pages;
+  for (k = 0; k < stats_phases; k++) {
+	p->time[k] = stats_acc[k] - stats_mark[k];
+	stats_mark[k] = stats_acc[k];
+  }
+  p->dvi_bytes = dvi_offset + dvi_ptr - stats_dvi_mark.dvi_bytes;
+  p->dvi_movements = dvi_movements - stats_dvi_mark.dvi_movements;
+  p->dvi_reused = dvi_movements_reused - stats_dvi_mark.dvi_reused;
+  stats_dvi_mark.dvi_bytes = dvi_offset + dvi_ptr;
+  stats_dvi_mark.dvi_movements = dvi_movements;
+  stats_dvi_mark.dvi_reused = dvi_movements_reused;
+}
+
+static void
+stats_put_times (FILE *f, stats_time *t) {
+  int k;
+  fputs ("\"time_us\": {", f);
+  for (k = 0; k < stats_phases; k++)
+	fprintf (f, "%s\"%s\": %llu", (k > 0 ? ", " : ""), stats_phase_name[k], t[k] / 1000);
+  fputs ("}", f);
+}
+
+static void
+stats_put_memory (FILE *f, stats_page *p) {
+  fprintf (f, "{\"var_used\": %ld, \"dyn_used\": %ld, \"str_ptr\": %ld, \"pool_ptr\": %ld, \"obj_ptr\": %ld}",
+		   (long)p->var_used, (long)p->dyn_used, (long)p->str_used, (long)p->pool_used, (long)p->obj_used);
+}
+
+/* The size of array |a| of |grow_size|, and its peak use. All but the
+ * strings only ever grow, so their peak is where they are now.
+ */
+static void
+stats_array_use (int a, integer *size, integer *peak) {
+  switch (a) {
+  case grow_mem:
+	*size = mem_max + 1 - mem_min;
+	*peak = lo_mem_max - mem_min + mem_end - hi_mem_min + 2;
+	break;
+  case grow_str_pool:
+	*size = pool_size;
+	*peak = (pool_ptr > max_pool_ptr ? pool_ptr : max_pool_ptr);
+	break;
+  case grow_str_start:
+	*size = max_strings;
+	*peak = (str_ptr > max_str_ptr ? str_ptr : max_str_ptr);
+	break;
+  case grow_font_info:
+	*size = font_mem_size;
+	*peak = fmem_ptr;
+	break;
+  case grow_trie:
+	*size = trie_size;
+	*peak = (trie_ptr > trie_max ? trie_ptr : trie_max);
+	break;
+  case grow_pdf_mem:
+	*size = pdf_mem_size;
+	*peak = pdf_mem_ptr;
+	break;
+  case grow_obj_tab:
+	*size = obj_tab_size;
+	*peak = obj_ptr;
+	break;
+  default:
+	*size = dest_names_size;
+	*peak = pdf_dest_names_ptr;
+	break;
+  }
+}
+
+/* Called with the other statistics of \.{\\tracingstats}: a line for each
+ * array that had to grow.
+ */
+void
+stats_log_growth (FILE *f) {
+  integer size, peak;
+  int a;
+  for (a = 0; a < grow_arrays; a++)
+	if (grow_count[a] > 0) {
+	  stats_array_use (a, &size, &peak);
+	  fprintf (f, " %s grew %ld time%s from %ld to %ld entries, %ld used\n", stats_array_name[a],
+			   (long)grow_count[a], (grow_count[a] == 1 ? "" : "s"),
+			   (long)grow_initial[a], (long)size, (long)peak);
+	}
+}
+
+/* Called from |close_files_and_terminate|, after the output file is finished */
+void
+stats_write_json (void) {
+  FILE *f;
+  stats_time rest[stats_phases];
+  stats_page last;
+  integer n, size, peak;
+  int k;
+  stats_charge();
+  f = fopen (stats_json_file, FOPEN_W_MODE);
+  if (f == NULL) {
+	WARNING1 ("Could not write the statistics to `%s'", stats_json_file);
+	return;
+  }
+  stats_sample_memory (&last);
+  fputs ("{\n  \"pages\": [", f);
+  for (n = 0; n < stats_pages_ptr; n++) {
+	fprintf (f, "%s\n    {\"page\": %ld, \"count0\": %ld, ", (n > 0 ? "," : ""),
+			 (long)stats_pages[n].page, (long)stats_pages[n].count0);
+	stats_put_times (f, stats_pages[n].time);
+	fputs (", \"memory\": ", f);
+	stats_put_memory (f, &stats_pages[n]);
+	if (fixed_output <= 0)
+	  fprintf (f, ", \"dvi\": {\"bytes\": %ld, \"movements\": %ld, \"reused\": %ld}",
+			   (long)stats_pages[n].dvi_bytes, (long)stats_pages[n].dvi_movements,
+			   (long)stats_pages[n].dvi_reused);
+	fputs ("}", f);
+  }
+  fputs ("\n  ],\n", f);
+  for (k = 0; k < stats_phases; k++)
+	rest[k] = stats_acc[k] - stats_mark[k];
+  fputs ("  \"after_last_page\": {", f);
+  stats_put_times (f, rest);
+  fputs (", \"memory\": ", f);
+  stats_put_memory (f, &last);
+  fputs ("},\n  \"total\": {", f);
+  stats_put_times (f, stats_acc);
+  fputs ("},\n  \"peak\": ", f);
+  stats_put_memory (f, &stats_peak);
+  fprintf (f, ",\n  \"fonts_loaded\": %ld,\n  \"fonts_embedded\": %ld,\n  \"images_loaded\": %ld,\n  \"arrays\": {",
+		   (long)(font_ptr - font_base), (long)stats_fonts_embedded, (long)pdf_ximage_count);
+  for (k = 0; k < grow_arrays; k++) {
+	stats_array_use (k, &size, &peak);
+	fprintf (f, "%s\n    \"%s\": {\"size\": %ld, \"peak\": %ld, \"grown\": %ld, \"initial\": %ld}",
+			 (k > 0 ? "," : ""), stats_array_name[k], (long)size, (long)peak, (long)grow_count[k],
+			 (long)(grow_count[k] > 0 ? grow_initial[k] : size));
+  }
+  fputs ("\n  }\n}\n", f);
+  fclose (f);
+}
@@ -0,0 +1,31 @@
+
+/* Run statistics, see stats.c */
+
+/* The phases that are timed separately. Each phase is charged only for
+ * the time it does not spend in other phases, so the numbers add up.
+ */
+#define stats_main_control 0 /* everything else, mostly |main_control| */
+#define stats_line_break 1
+#define stats_build_page 2
+#define stats_ship_out 3
+#define stats_deflate 4
+#define stats_images 5 /* reading and embedding images */
+#define stats_fonts 6 /* embedding fonts */
+#define stats_phases 7
+
+EXTERN const_string stats_json_file; /* name given to \.{--stats-json}, or |NULL| */
+EXTERN boolean stats_enabled; /* are statistics being collected? */
+EXTERN integer stats_fonts_embedded; /* calls of |do_pdf_font| */
+
+EXTERN void stats_start (void);
+EXTERN void stats_phase_enter (int phase);
+EXTERN void stats_phase_leave (void);
+EXTERN void stats_ship_begin (void);
+EXTERN void stats_ship_end (void);
+EXTERN void stats_write_json (void);
+EXTERN void stats_log_growth (FILE *f);
+
+/* The hooks cost only a test of |stats_enabled| when the option is off */
+#define stats_enter(a) { if (stats_enabled) stats_phase_enter(a); }
+#define stats_leave    { if (stats_enabled) stats_phase_leave(); }
+
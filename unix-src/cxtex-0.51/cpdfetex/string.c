@@ -23,6 +23,31 @@ pool_pointer pool_ptr; /* first unused position in |str_pool| */
 str_number str_ptr; /* number of the current string being created */
 pool_pointer init_pool_ptr; /* the starting value of |pool_ptr| */
 str_number init_str_ptr; /* the starting value of |str_ptr| */
+pool_pointer max_pool_ptr = 0; /* largest value of |pool_ptr| seen by |make_string| */
+str_number max_str_ptr = 0; /* largest value of |str_ptr| */
+
+/* |str_room| and |strings_room| call these when |str_pool| or |str_start|
+ * is full; the arrays are reallocated at about twice the size.
+ */
+void
+str_pool_grow (integer l) {
+  integer n;
+  n = grow_size (grow_str_pool, pool_size, pool_ptr + l, max_halfword);
+  if (n == pool_size)
+	overflow ("pool size", pool_size - init_pool_ptr);
+  str_pool = xrealloc (str_pool, (n + 1) * sizeof (packed_ASCII_code));
+  pool_size = n;
+}
+
+void
+str_start_grow (integer l) {
+  integer n;
+  n = grow_size (grow_str_start, max_strings, str_ptr + l, max_halfword);
+  if (n == max_strings)
+	overflow ("number of strings", max_strings - init_str_ptr);
+  str_start = xrealloc (str_start, (n + 1) * sizeof (pool_pointer));
+  max_strings = n;
+}
 
 /* module 43 */
 
@@ -36,6 +61,10 @@ make_string (void) {  /* current string enters the pool */
   strings_room(1);
   str_ptr++;
   str_start[str_ptr] = pool_ptr;
+  if (str_ptr > max_str_ptr)
+	max_str_ptr = str_ptr;
+  if (pool_ptr > max_pool_ptr)
+	max_pool_ptr = pool_ptr;
   return str_ptr-1;
 };
 
@@ -192,7 +221,7 @@ slow_make_tex_string (char *ss) {
   len = strlen(ss);
   if(len==0) 
     return null_string;
-  checkpoolpointer (pool_ptr, len);
+  str_room (len);
   s=ss;
   while (len-- > 0)
       str_pool[pool_ptr++] = *s++;
@@ -210,15 +239,6 @@ gettexstring (str_number s) {
   return xname;
 }
 
-/* FIXME -- some (most?) of this can/should be moved to the Pascal/WEB side. */
-void
-checkpoolpointer (pool_pointer pool_ptrj, size_t len) {
-  if (pool_ptrj + (integer)len >= pool_size) {
-    fprintf (stderr, "\nstring pool overflow [%i bytes]\n",  (int)pool_size); /* fixme */
-    exit(1);
-  }
-}
-
 void 
 flush_str (str_number s) {			
   /* flush a string if possible */
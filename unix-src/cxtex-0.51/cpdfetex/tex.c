@@ -420,19 +420,6 @@ initialize (void) {
 };
 
 
-/* module 241 */
-
-/* The following procedure, which is called just before \TeX\ initializes its
- * input and output, establishes the initial values of the date and time.
- * It calls a macro-defined |date_and_time| routine. |date_and_time|
- * in turn is a C macro, which calls |get_date_and_time|, passing
- * it the addresses of the day, month, etc., so they can be set by the
- * routine. |get_date_and_time| also sets up interrupt catching if that
- * is conditionally compiled in the C code.
- */
-#define fix_date_and_time  \
-  get_date_and_time (address_of(tex_time), address_of(day), address_of(month), address_of(year))
-
 /* module 1475 */
 
 /* 
@@ -1174,6 +1161,7 @@ void init_prim (int noninit) {	/* initialize all the primitives */
   primitive_str("pdffontexpand", extension,pdf_font_expand_code);
   primitive_str("pdfmapfile", extension,pdf_map_file_code);
   primitive_str("pdftrailer", extension,pdf_trailer_code);
+  primitive_str("savecheckpoint", extension,save_checkpoint_code);
   /* end expansion of Put each... */
   set_no_new_control_sequence(true);
 };
@@ -1520,7 +1508,7 @@ main_body (void) {	 /* |start_here| */
   dest_names = xmalloc_array (dest_name_entry, dest_names_size);
 #ifdef INIT
   if (ini_version) {
-    yzmem = xmalloc_array (memory_word, mem_top - mem_bot);
+    yzmem = mem_alloc (mem_bot, mem_top);
     mem = yzmem - mem_bot; /* Some compilers require |mem_bot=0| */
     eqtb = xmalloc_array (memory_word, eqtb_size);
     font_info = xmalloc_array (fmemory_word, font_mem_size);
@@ -1738,12 +1726,14 @@ main_body (void) {	 /* |start_here| */
     /* begin expansion of Initialize the print |selector|... */
     initialize_selector;
     /* end expansion of Initialize the print |selector|... */
-    if ((loc < limit) && (cat_code (buffer[loc]) != escape)) {
-	  start_input(); /* \.{\\input} assumed */
-	} 
-    /* begin expansion of Read values from config file if necessary */
-    read_values_from_config_file();
-    /* end expansion of Read values from config file if necessary */
+    if (!resume_checkpoint()) {
+      if ((loc < limit) && (cat_code (buffer[loc]) != escape)) {
+        start_input(); /* \.{\\input} assumed */
+      } 
+      /* begin expansion of Read values from config file if necessary */
+      read_values_from_config_file();
+      /* end expansion of Read values from config file if necessary */
+    }
   };
   /* end expansion of Get the first line of input and prepare to start */
   history = spotless; /* ready to go! */ 
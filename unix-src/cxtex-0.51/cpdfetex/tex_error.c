@@ -338,6 +338,32 @@ overflow (char *s, int n) { /* stop due to finiteness */
   succumb;
 };
 
+/* With \.{-auto-grow}, the arrays whose sizes are set up by |setup_bound_var|
+ * are made larger when they fill up, and |overflow| is only called when an
+ * array has reached its |sup| value. |grow_size| gives the new size for array
+ * |a| of |n| entries when |need| entries are wanted: twice as many, but at
+ * least |need| and at most |sup|. It returns |n| if the array may not grow,
+ * and then the caller stops as before. The string pool and |str_start| have
+ * always been grown by |str_room| and |strings_room|, option or not.
+ */
+boolean auto_grow_p = false;
+integer grow_count[grow_arrays]; /* how often each array has grown */
+integer grow_initial[grow_arrays]; /* and its size before the first time */
+
+integer
+grow_size (int a, integer n, integer need, integer sup) {
+  integer m;
+  if ((!auto_grow_p && a != grow_str_pool && a != grow_str_start) || need > sup)
+	return n;
+  m = (n > sup / 2 ? sup : 2 * n);
+  if (m < need)
+	m = need;
+  if (grow_count[a] == 0)
+	grow_initial[a] = n;
+  incr (grow_count[a]);
+  return m;
+}
+
 /* module 95 */
 
 /* The program might sometime run completely amok, at which point there is
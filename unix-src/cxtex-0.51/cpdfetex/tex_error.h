@@ -82,6 +82,22 @@ EXTERN void jump_out (void);
 EXTERN void error (void);
 EXTERN void fatal_error (char *s);
 EXTERN void overflow (char *s, int n);
+
+/* The arrays that can grow, see |grow_size| */
+#define grow_mem 0
+#define grow_str_pool 1
+#define grow_str_start 2
+#define grow_font_info 3
+#define grow_trie 4
+#define grow_pdf_mem 5
+#define grow_obj_tab 6
+#define grow_dest_names 7
+#define grow_arrays 8
+
+EXTERN boolean auto_grow_p; /* was \.{-auto-grow} given? */
+EXTERN integer grow_count[grow_arrays];
+EXTERN integer grow_initial[grow_arrays];
+EXTERN integer grow_size (int a, integer n, integer need, integer sup);
 EXTERN void confusion (char *s);
 
 EXTERN void normalize_selector (void);
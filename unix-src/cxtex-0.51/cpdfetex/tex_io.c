@@ -869,6 +869,7 @@ open_or_close_in (void) {
       end_name();
       name_in_progress = false;
       read_open[n] = just_open;
+      checkpoint_note_file (stringcast (name_of_file + 1));
     };
   };
 }
@@ -935,8 +936,11 @@ close_files_and_terminate (void) {
 				" named destinations out of "     , (long)dest_names_size ) ;
 	  fprintf ( log_file , "%c%ld%s%ld\n",  ' ' , (long)pdf_mem_ptr , 
 				" words of extra memory for PDF output out of ", (long)pdf_mem_size ) ;
+	  stats_log_growth (log_file);
 	};
   /* end expansion of Output statistics about this job */
+  if (profiling_macros)
+	profile_macros_write();
   wake_up_terminal;
   if (fixed_output > 0) {
 	if (history == fatal_error_stop) {
@@ -949,6 +953,8 @@ close_files_and_terminate (void) {
 	/* Finish the \.{DVI} file */
 	finish_dvi_file();
   };
+  if (stats_enabled)
+	stats_write_json();
   if (log_opened) {
 	wlog_cr;
 	a_close (log_file);
@@ -1053,6 +1059,7 @@ start_input (void) { /* \TeX\ will \.{\\input} something */
   name = a_make_name_string (cur_file);
   source_filename_stack[in_open] = name;
   full_source_filename_stack[in_open] = make_full_name_string();
+  checkpoint_note_file (makecstring (full_source_filename_stack[in_open]));
   if (name == str_ptr - 1)	{/* we can try to conserve string pool space now */
 	temp_str = search_string (name);
 	if (temp_str > 0) {
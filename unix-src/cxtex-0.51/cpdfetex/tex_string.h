@@ -32,6 +32,8 @@ EXTERN pool_pointer pool_ptr; /* first unused position in |str_pool| */
 EXTERN str_number str_ptr; /* number of the current string being created */
 EXTERN pool_pointer init_pool_ptr; /* the starting value of |pool_ptr| */
 EXTERN str_number init_str_ptr; /* the starting value of |str_ptr| */
+EXTERN pool_pointer max_pool_ptr; /* largest value of |pool_ptr| seen by |make_string| */
+EXTERN str_number max_str_ptr; /* largest value of |str_ptr| */
 
 /* module 40 */
 
@@ -58,47 +60,30 @@ EXTERN str_number init_str_ptr; /* the starting value of |str_ptr| */
  * macro, which erases the last character appended.
  * 
  * To test if there is room to append |l| more characters to |str_pool|,
- * we shall write |str_room(l)|, which aborts \TeX\ and gives an
- * apologetic error message if there isn't enough room.
+ * we shall write |str_room(l)|, which makes |str_pool| larger if there
+ * isn't enough room; see |str_pool_grow|.
  */
 #define append_char( arg ) { str_pool [ pool_ptr ]  =  arg ; incr ( pool_ptr );}
 #define flush_char  decr ( pool_ptr )
 
 #define str_room(arg) {                                                            \
-  if (pool_ptr + arg > pool_size) {                                                \
-    str_pool = xrealloc_array(str_pool,sizeof(packed_ASCII_code)*pool_size*2);     \
-	if (str_pool == NULL) {                                                        \
-	  overflow ("pool size", pool_size - init_pool_ptr);                           \
-	} else {                                                                       \
-      pool_size = pool_size*2;                                                     \
-    }                                                                              \
-  }                                                                                \
+  if (pool_ptr + arg > pool_size)                                                  \
+    str_pool_grow (arg);                                                           \
 }
 
-/* this is perhaps not as useful as the realloc in str_room. */
-
 #define strings_room(arg) {                                                       \
-  if (str_ptr + arg > max_strings) {                                              \
-    if (max_strings*2 > max_halfword) {                                           \
-     overflow ("number of strings", max_strings - init_str_ptr);                  \
-    } else {                                                                      \
-      str_start = xrealloc_array(str_start,sizeof(pool_pointer)*max_strings*2);   \
-      if (str_start == NULL) {                                                    \
-        overflow ("number of strings", max_strings - init_str_ptr);               \
-      } else {                                                                    \
-        max_strings= max_strings*2;                                               \
-      }                                                                           \
-    }                                                                             \
-  }                                                                               \
+  if (str_ptr + arg > max_strings)                                                \
+    str_start_grow (arg);                                                         \
 }
 
-
 /* module 44 */
 
 /* To destroy the most recently made string, we say |flush_string|.
  */
 #define flush_string { decr ( str_ptr ); pool_ptr   =  str_start [ str_ptr ];}
 
+EXTERN void str_pool_grow (integer l);
+EXTERN void str_start_grow (integer l);
 EXTERN str_number make_string (void);
 EXTERN boolean str_eq_buf (str_number, int);
 EXTERN boolean str_eq_str (str_number, str_number);
@@ -107,7 +92,6 @@ EXTERN str_number slow_make_string (void);
 EXTERN boolean get_strings_started(void);
 EXTERN str_number   slow_make_tex_string (char *);
 EXTERN string       gettexstring (str_number);
-EXTERN void         checkpoolpointer (pool_pointer, size_t);
 
 EXTERN void flush_str (str_number);
 EXTERN boolean str_in_str (str_number, char *, int);
@@ -382,7 +382,8 @@ read_font_info (pointer u, str_number nom, str_number aire, scaled s) {
   lf = lf - 6 - lh; /* |lf| words should be loaded into |font_info| */ 
   if (np < 7)
     lf = lf + 7 - np; /* at least seven parameters will appear */ 
-  if ((font_ptr == font_max) || (fmem_ptr + lf > font_mem_size)) {
+  if ((font_ptr == font_max)
+	  || ((fmem_ptr + lf > font_mem_size) && !font_info_grow (fmem_ptr + lf))) {
 	/* begin expansion of Apologize for not loading the font, |goto done| */
 	/* module 567 */
 	start_font_error_message;
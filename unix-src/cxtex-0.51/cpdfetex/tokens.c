@@ -258,6 +258,17 @@ firm_up_the_line (void) {
 };
 
 
+unsigned char cat_class[256];
+boolean cat_class_valid = false;
+
+void
+update_cat_class (void) {
+  int k;
+  for (k = 0; k <= 255; k++)
+    cat_class[k] = cat_code (k);
+  cat_class_valid = true;
+}
+
 signed char
 input_from_external_file (void) {
   unsigned char Restart;
@@ -267,13 +278,21 @@ input_from_external_file (void) {
   signed char d;		/* number of excess characters in an expanded code */
   cc = 0; /*TH -Wall -O2 */
   Restart = 0;
+  if (!cat_class_valid)
+    update_cat_class();
   /* module 343 */
  SWITCH:
   if (loc <= limit) { /* current line not yet finished */
     cur_chr = buffer[loc];
     incr (loc);
   RESWITCH:
-    cur_cmd = cat_code (cur_chr);
+    cur_cmd = cat_class[cur_chr];
+    /* Letters and other characters are most of the input, and in every
+     * state they do nothing but set |state:=mid_line| */
+    if ((cur_cmd == letter) || (cur_cmd == other_char)) {
+      state = mid_line;
+      return Restart;
+    }
     /* begin expansion of Change state if necessary, and |goto switch| if the current 
        character should be ignored, or |goto reswitch| if the current character 
        changes to another */
@@ -315,7 +334,7 @@ input_from_external_file (void) {
       START_CS:
 	k = loc;
 	cur_chr = buffer[k];
-	cat = cat_code (cur_chr);
+	cat = cat_class[cur_chr];
 	incr (k);
 	if (cat == letter) {
 	  state = skip_blanks;
@@ -330,11 +349,11 @@ input_from_external_file (void) {
 	     otherwise if a multiletter control
 	     sequence is found, adjust |cur_cs| and |loc|, and |goto found| */
 	  /* module 356 */
-	  do {
-	    cur_chr = buffer[k];
-	    cat = cat_code (cur_chr);
-	    incr (k);
-	  } while (!((cat != letter) || (k > limit)));
+	  while ((k < limit) && (cat_class[buffer[k]] == letter))
+	    incr (k); /* the bulk of the name */
+	  cur_chr = buffer[k];
+	  cat = cat_class[cur_chr];
+	  incr (k);
 	  /* If an expanded... */
 	  if_an_expanded;
 	  if (cat != letter)
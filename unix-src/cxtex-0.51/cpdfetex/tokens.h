@@ -31,6 +31,22 @@ EXTERN halfword par_token; /* token representing `\.{\\par}' */
 
 EXTERN boolean force_eof; /* should the next \.{\\input} be aborted early? */
 
+/* |cat_class| is a byte copy of the 256 |cat_code| entries of |eqtb|, for
+ * the inner loop of |get_next|. Every assignment or restore of a catcode
+ * calls |cat_code_changed|, and the copy is refreshed from |eqtb| before
+ * the next character is read from a file.
+ */
+EXTERN unsigned char cat_class[256];
+EXTERN boolean cat_class_valid;
+
+#define cat_code_changed(arg) {                               \
+  if (((arg) >= cat_code_base) && ((arg) < lc_code_base))     \
+    cat_class_valid = false;                                  \
+ }
+
+EXTERN integer state_toklist_csname; /* tokens read from token lists, see |get_next| */
+EXTERN integer state_toklist_normal;
+
 
 EXTERN void get_next (void);
 EXTERN void get_token (void);
@@ -38,5 +54,6 @@ EXTERN void get_x_token (void);
 EXTERN void x_token (void);
 EXTERN void get_x_or_protected (void);
 EXTERN void firm_up_the_line (void);
+EXTERN void update_cat_class (void);
 
 
@@ -67,7 +67,7 @@ int hyph_next; /* next free slot in hyphen exceptions hash table */
  * The hash table is called |trie_op_hash|, and the number of entries it contains
  * is |trie_op_ptr|.
  */
-integer trie_op_hashz[(2*trie_op_size+1)]; /* trie op codes for quadruples */
+integer trie_op_hashz[(2*trie_op_size+2)]; /* trie op codes for quadruples */
 #define trie_op_hash(arg) trie_op_hashz[(arg+trie_op_size+1)]
 trie_opcode trie_used[257]; /* largest opcode used so far for this language */
 ASCII_code trie_op_lang[trie_op_size]; /* language part of a hashed 
@@ -287,7 +287,7 @@ first_fit (trie_pointer p) {			/* packs a family into |trie| */
 	 */
 	if (trie_max < h + 256) {
 	  if (trie_size <= h + 256)
-		overflow ("pattern memory", trie_size);
+		trie_grow (h + 257);
 	  do {
 		incr (trie_max);
 		trie_taken[trie_max] = false;
@@ -390,9 +390,10 @@ trie_fix (trie_pointer p) {	/* moves |p| and its siblings into |trie| */
 
 /* module 1108 */
 /* Insert a new trie node between |q| and |p|, and make |p| point to it */
-#define insert_trie_node                             \
-		if (trie_ptr == trie_size)                   \
-		  overflow ("pattern memory", trie_size);    \
+#define insert_trie_node do {                        \
+		if (trie_ptr == trie_size) {                 \
+		  trie_grow (trie_ptr + 1);                  \
+		}                                            \
 		incr (trie_ptr);                             \
 		trie_r[trie_ptr] = p;                        \
 		p = trie_ptr;                                \
@@ -403,7 +404,8 @@ trie_fix (trie_pointer p) {	/* moves |p| and its siblings into |trie| */
 		  trie_r[q] = p;                             \
 		}                                            \
 		trie_c[p] =      c;                          \
-		trie_o[p] = min_trie_op             
+		trie_o[p] = min_trie_op;                     \
+	} while (0)
 
 /* module 1104 */
 
@@ -758,6 +760,29 @@ trie_xmalloc (integer trie_size) {
   hyph_start = 0;
 }
 
+/* With \.{-auto-grow}, all the arrays above are made larger together when
+ * the patterns do not fit. That can happen while the patterns are read or
+ * while they are packed, but not while |compress_trie| uses |trie_hash|,
+ * whose hash function depends on |trie_size|.
+ */
+void
+trie_grow (integer need) {
+  integer n;
+  n = grow_size (grow_trie, trie_size, need, sup_trie_size);
+  if (n == trie_size)
+	overflow ("pattern memory", trie_size);
+  trie_trl = xrealloc (trie_trl, (n + 1) * sizeof (trie_pointer));
+  trie_tro = xrealloc (trie_tro, (n + 1) * sizeof (trie_pointer));
+  trie_trc = xrealloc (trie_trc, (n + 1) * sizeof (quarterword));
+  trie_c = xrealloc (trie_c, (n + 1) * sizeof (packed_ASCII_code));
+  trie_o = xrealloc (trie_o, (n + 1) * sizeof (trie_opcode));
+  trie_l = xrealloc (trie_l, (n + 1) * sizeof (trie_pointer));
+  trie_r = xrealloc (trie_r, (n + 1) * sizeof (trie_pointer));
+  trie_hash = xrealloc (trie_hash, (n + 1) * sizeof (trie_pointer));
+  trie_taken = xrealloc (trie_taken, (n + 1) * sizeof (boolean));
+  trie_size = n;
+}
+
 /* module 1072 */
 void
 trie_initialize (void) {
@@ -891,7 +916,14 @@ undump_trie (void) {
   } else
     if (hyph_next >= hyph_prime)
       incr (hyph_next);
-  UNDUMP_SIZE (0,trie_size,"trie size",j);
+  /* a format dumped after |trie_grow| has a longer trie than |trie_size| */
+  if (auto_grow_p) {
+	UNDUMP_SIZE (0,sup_trie_size,"trie size",j);
+	if (j > trie_size)
+	  trie_size = j;
+  } else {
+	UNDUMP_SIZE (0,trie_size,"trie size",j);
+  }
   trie_max = j;
   UNDUMP (0,j,hyph_start);
   /* These first three haven't been allocated yet unless we're \.{INITEX}; w
@@ -22,12 +22,15 @@ EXTERN hyph_pointer *hyph_link;
 EXTERN int hyph_count;
 EXTERN int hyph_next;
 EXTERN boolean trie_not_ready;
+EXTERN trie_pointer trie_ptr; /* the number of nodes in the trie */
+EXTERN trie_pointer trie_max; /* largest location used in |trie| */
 
 EXTERN void new_patterns (void);
 EXTERN void init_trie (void);
 EXTERN void trie_initialize (void);
 EXTERN void trie_initialize_init (void);
 EXTERN void trie_xmalloc (integer size);
+EXTERN void trie_grow (integer need);
 
 /* module 1803 */
 #define set_hyph_index   if (trie_char (hyph_start + cur_lang) !=  qi (cur_lang)) { hyph_index = 0; }\
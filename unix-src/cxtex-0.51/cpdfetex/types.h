@@ -440,6 +440,13 @@ typedef struct {
   scaled stack_h, stack_v, stack_w, stack_x, stack_y, stack_z;
 } vf_stack_record;
 
+/* A character packet compiled by |vf_compile_packet|, see vf.c */
+typedef struct {
+  int op; /* what to do */
+  integer a, b; /* a character and its font, a rule, or a movement */
+  char *s; /* the text of a special */
+} vf_instruction;
+
 
 /* module 1064 */
 
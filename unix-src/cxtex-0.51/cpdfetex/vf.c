@@ -444,175 +444,233 @@ packet_scaled (int k) {
 
 /* module 692 */
 
-/* The |do_vf_packet| procedure is called in order to interpret the
- * character packet for a virtual character. Such a packet may contain the
- * instruction to typeset a character from the same or an other virtual
- * font; in such cases |do_vf_packet| calls itself recursively. The
- * recursion level, i.e., the number of times this has happened, is kept
- * in the global variable |vf_cur_s| and should not exceed |vf_max_recursion|.
+/* Reading a packet means decoding its bytes one by one, scaling every
+ * movement and looking up every local font, and a virtual character is
+ * usually shipped out many times. So each packet is compiled once, the
+ * first time it is needed, into an array of |vf_instruction|s, which is
+ * kept next to the packet (see vfpacket.c). In the array the movements are
+ * already scaled and add up to one |vf_op_move| wherever several follow
+ * each other, the |w|, |x|, |y| and |z| commands have become plain
+ * movements, and the characters carry the internal number of their font.
+ * A movement at the very end is left out, since the position is restored
+ * after the packet anyway.
  */
+#define vf_emit(arg) { code[n].op = arg; code[n].s = NULL; incr (n); }
+#define vf_emit_move if ((dh != 0) || (dv != 0)) {                      \
+    code[n].a = dh; code[n].b = dv; vf_emit (vf_op_move);               \
+    dh = 0; dv = 0; }
 
-void 
-do_vf_packet  (internal_font_number f, eight_bits c) {
-  /* typeset the \.{DVI} commands in the character packet 
-	 for character |c| in current font |f| */
-  internal_font_number save_vf, k, n;
-  scaled save_h, save_v; /*base_line*/
-  int cmd;
-  boolean char_move;
-  scaled w, x, y, z;
-  str_number s;
-  incr (vf_cur_s);
-  if (vf_cur_s > vf_max_recursion)
-	overflow ("max level recursion", vf_max_recursion);
-  push_packet_state();
+static vf_instruction *
+vf_compile_packet (internal_font_number f, eight_bits c) {
+  vf_instruction *code;
+  int n; /* the number of instructions so far */
+  internal_font_number ff, k, m;
+  int cmd, l;
+  scaled w, x, y, z, dh, dv;
+  vf_stack_record regs[vf_stack_size + 1]; /* |w|, |x|, |y| and |z| at each |push| */
+  int regs_ptr;
   start_packet (f, c);
+  /* every instruction takes at least one byte of the packet */
+  code = xmalloc_array (vf_instruction, vfpacketlength);
+  n = 0;
   vf_z = font_size[f];
   vf_replace_z();
-  save_vf = f;
-  f = vf_i_fnts[vf_default_font[save_vf]];
-  save_v = cur_v;
-  save_h = cur_h;
+  ff = vf_i_fnts[vf_default_font[f]];
   w = 0;
   x = 0;
   y = 0;
   z = 0;
+  dh = 0;
+  dv = 0;
+  regs_ptr = 0;
   while (vfpacketlength > 0) {
 	cmd = packet_byte();
-	/* begin expansion of Do typesetting the \.{DVI} commands in virtual character packet */
-	/* module 697 */
-	/* The following code typesets a character to PDF output.
-	 */
 	if ((cmd >= set_char_0) && (cmd <= set_char_0 + 127)) {
-	  if (!is_valid_char (cmd)) {
-		char_warning (f, cmd);
-		goto CONTINUE;
-	  };
-	  c = cmd;
-	  char_move = true;
-	  goto DO_CHAR;
+	  vf_emit_move;
+	  code[n].a = cmd;
+	  code[n].b = ff;
+	  vf_emit (vf_op_set_char);
 	} else if (((fnt_num_0 <= cmd) && (cmd <= fnt_num_0 + 63)) || (cmd == fnt1)) {
 	  if (cmd == fnt1) {
 		k = packet_byte();
 	  } else {
 		k = cmd - fnt_num_0;
 	  }
-	  n = 0;
-	  while ((n < vf_local_font_num[save_vf]) && (vf_e_fnts[vf_default_font[save_vf] + n] != k))
-		incr (n);
-	  if ((n == vf_local_font_num[save_vf])) {
-		f = null_font;
+	  m = 0;
+	  while ((m < vf_local_font_num[f]) && (vf_e_fnts[vf_default_font[f] + m] != k))
+		incr (m);
+	  if ((m == vf_local_font_num[f])) {
+		ff = null_font;
 	  } else {
-		f = vf_i_fnts[vf_default_font[save_vf] + n];
+		ff = vf_i_fnts[vf_default_font[f] + m];
 	  }
 	} else {
 	  switch (cmd) {
 	  case push:
-		vf_stack[vf_stack_ptr].stack_h = cur_h;
-		vf_stack[vf_stack_ptr].stack_v = cur_v;
-		vf_stack[vf_stack_ptr].stack_w = w;
-		vf_stack[vf_stack_ptr].stack_x = x;
-		vf_stack[vf_stack_ptr].stack_y = y;
-		vf_stack[vf_stack_ptr].stack_z = z;
-		incr (vf_stack_ptr);
+		vf_emit_move;
+		vf_emit (vf_op_push);
+		regs[regs_ptr].stack_w = w;
+		regs[regs_ptr].stack_x = x;
+		regs[regs_ptr].stack_y = y;
+		regs[regs_ptr].stack_z = z;
+		incr (regs_ptr);
 		break;
 	  case pop:
-		decr (vf_stack_ptr);
-		cur_h = vf_stack[vf_stack_ptr].stack_h;
-		cur_v = vf_stack[vf_stack_ptr].stack_v;
-		w = vf_stack[vf_stack_ptr].stack_w;
-		x = vf_stack[vf_stack_ptr].stack_x;
-		y = vf_stack[vf_stack_ptr].stack_y;
-		z = vf_stack[vf_stack_ptr].stack_z;
+		vf_emit_move;
+		vf_emit (vf_op_pop);
+		decr (regs_ptr);
+		w = regs[regs_ptr].stack_w;
+		x = regs[regs_ptr].stack_x;
+		y = regs[regs_ptr].stack_y;
+		z = regs[regs_ptr].stack_z;
 		break;
 	  case FOUR_CASES (set1):
+		vf_emit_move;
+		code[n].a = packet_read (cmd - set1 + 1);
+		code[n].b = ff;
+		vf_emit (vf_op_set_char);
+		break;
 	  case FOUR_CASES (put1):
-		if ((set1 <= cmd) && (cmd <= set1 + 3)) {
-		  tmp_int = packet_read (cmd - set1 + 1);
-		  char_move = true;
-		} else {
-		  tmp_int = packet_read (cmd - put1 + 1);
-		  char_move = false;
-		};
-		if (!is_valid_char (tmp_int)) {
-		  char_warning (f, tmp_int);
-		  goto CONTINUE;
-		};
-		c = tmp_int;		  
-		goto DO_CHAR;
+		vf_emit_move;
+		code[n].a = packet_read (cmd - put1 + 1);
+		code[n].b = ff;
+		vf_emit (vf_op_put_char);
+		break;
 	  case set_rule:
 	  case put_rule:
-		rule_ht = packet_scaled (4);
-		rule_wd = packet_scaled (4);
-		if ((rule_wd > 0) && (rule_ht > 0)) {
-		  pdf_set_rule (cur_h, cur_v, rule_wd, rule_ht);
-		  if (cmd == set_rule)
-			cur_h = cur_h + rule_wd;
-		};
+		vf_emit_move;
+		code[n].a = packet_scaled (4);
+		code[n].b = packet_scaled (4);
+		vf_emit (cmd == set_rule ? vf_op_set_rule : vf_op_put_rule);
 		break;
 	  case FOUR_CASES (right1):
-		cur_h = cur_h + packet_scaled (cmd - right1 + 1);
+		dh = dh + packet_scaled (cmd - right1 + 1);
 		break;
 	  case w0:
 	  case FOUR_CASES (w1):
 		if (cmd > w0)
 		  w = packet_scaled (cmd - w0);
-		cur_h = cur_h + w;
+		dh = dh + w;
 		break;
 	  case x0:
 	  case FOUR_CASES (x1):
 		if (cmd > x0)
 		  x = packet_scaled (cmd - x0);
-		cur_h = cur_h + x;
+		dh = dh + x;
 		break;
 	  case FOUR_CASES (down1):
-		cur_v = cur_v + packet_scaled (cmd - down1 + 1);
+		dv = dv + packet_scaled (cmd - down1 + 1);
 		break;
 	  case y0:
 	  case FOUR_CASES (y1):
 		if (cmd > y0)
 		  y = packet_scaled (cmd - y0);
-		cur_v = cur_v + y;
+		dv = dv + y;
 		break;
 	  case z0:
 	  case FOUR_CASES (z1):
 		if (cmd > z0)
 		  z = packet_scaled (cmd - z0);
-		cur_v = cur_v + z;
+		dv = dv + z;
 		break;
 	  case FOUR_CASES (xxx1):
-		tmp_int = packet_read (cmd - xxx1 + 1);
-		str_room (tmp_int);
-		while (tmp_int > 0) {
-		  decr (tmp_int);
-		  append_char (packet_byte());
-		};
-		s = make_string();
-		literal (s, true, true, false);
-		flush_str (s);
+		vf_emit_move;
+		l = packet_read (cmd - xxx1 + 1);
+		code[n].a = l;
+		vf_emit (vf_op_special);
+		code[n - 1].s = xmalloc_array (char, l);
+		for (k = 0; k < l; k++)
+		  code[n - 1].s[k] = packet_byte();
 		break;
 	  default:
 		pdf_error_string("vf","invalid DVI command");
 	  };
 	};
-	goto CONTINUE;
-  DO_CHAR:
-	if (is_valid_char (c)) {
+  };
+  vf_emit (vf_op_end);
+  store_packet_code (f, c, code);
+  return code;
+}
+
+/* The |do_vf_packet| procedure is called in order to interpret the
+ * character packet for a virtual character. Such a packet may contain the
+ * instruction to typeset a character from the same or an other virtual
+ * font; in such cases |do_vf_packet| calls itself recursively. The
+ * recursion level, i.e., the number of times this has happened, is kept
+ * in the global variable |vf_cur_s| and should not exceed |vf_max_recursion|.
+ */
+
+void 
+do_vf_packet  (internal_font_number f, eight_bits c) {
+  /* typeset the \.{DVI} commands in the character packet 
+	 for character |c| in current font |f| */
+  scaled save_h, save_v; /*base_line*/
+  vf_instruction *p;
+  pool_pointer k;
+  str_number s;
+  incr (vf_cur_s);
+  if (vf_cur_s > vf_max_recursion)
+	overflow ("max level recursion", vf_max_recursion);
+  p = packet_code (f, c);
+  if (p == NULL)
+	p = vf_compile_packet (f, c);
+  save_v = cur_v;
+  save_h = cur_h;
+  for (; p->op != vf_op_end; p++) {
+	/* begin expansion of Do typesetting the \.{DVI} commands in virtual character packet */
+	/* module 697 */
+	/* The following code typesets a character to PDF output.
+	 */
+	switch (p->op) {
+	case vf_op_set_char:
+	case vf_op_put_char:
+	  f = p->b;
+	  if (!is_valid_char (p->a)) {
+		char_warning (f, p->a);
+		break;
+	  };
+	  c = p->a;
 	  output_one_char (c);
-	} else {
-	  char_warning (f, c);
-	}
-	if (char_move)
-	  cur_h = cur_h + char_width (f, char_info (f, c));
+	  if (p->op == vf_op_set_char)
+		cur_h = cur_h + char_width (f, char_info (f, c));
+	  break;
+	case vf_op_set_rule:
+	case vf_op_put_rule:
+	  rule_ht = p->a;
+	  rule_wd = p->b;
+	  if ((rule_wd > 0) && (rule_ht > 0)) {
+		pdf_set_rule (cur_h, cur_v, rule_wd, rule_ht);
+		if (p->op == vf_op_set_rule)
+		  cur_h = cur_h + rule_wd;
+	  };
+	  break;
+	case vf_op_move:
+	  cur_h = cur_h + p->a;
+	  cur_v = cur_v + p->b;
+	  break;
+	case vf_op_push:
+	  vf_stack[vf_stack_ptr].stack_h = cur_h;
+	  vf_stack[vf_stack_ptr].stack_v = cur_v;
+	  incr (vf_stack_ptr);
+	  break;
+	case vf_op_pop:
+	  decr (vf_stack_ptr);
+	  cur_h = vf_stack[vf_stack_ptr].stack_h;
+	  cur_v = vf_stack[vf_stack_ptr].stack_v;
+	  break;
+	case vf_op_special:
+	  str_room (p->a);
+	  for (k = 0; k < p->a; k++)
+		append_char (p->s[k]);
+	  s = make_string();
+	  literal (s, true, true, false);
+	  flush_str (s);
+	  break;
+	};
 	/* end expansion of Do typesetting the \.{DVI} commands in virtual character packet */
-  CONTINUE: 
-	do_nothing; 
   };
   cur_h = save_h;
   cur_v = save_v;
-  pop_packet_state();
-  vf_z = font_size[f];
-  vf_replace_z();
   decr (vf_cur_s);
 };
 
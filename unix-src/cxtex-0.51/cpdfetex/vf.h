@@ -16,6 +16,17 @@
 
 EXTERN integer              *vfpacketbase;
 
+/* The |op| codes of a |vf_instruction| */
+#define vf_op_end 0 /* the end of the packet */
+#define vf_op_set_char 1 /* |a| in font |b|, then move right */
+#define vf_op_put_char 2 /* |a| in font |b| */
+#define vf_op_set_rule 3 /* height |a| and width |b|, then move right */
+#define vf_op_put_rule 4 /* height |a| and width |b| */
+#define vf_op_move 5 /* right by |a| and down by |b| */
+#define vf_op_push 6
+#define vf_op_pop 7
+#define vf_op_special 8 /* |a| bytes of text in |s| */
+
 EXTERN void do_vf (void);
 EXTERN void do_vf_packet  (internal_font_number f, eight_bits c);
 EXTERN void vf_initialize (void);
@@ -12,6 +12,8 @@
 #define check_image_c checkimagec 
 #define check_image_i checkimagei 
 #define packet_byte packetbyte
+#define packet_code packetcode
+#define store_packet_code storepacketcode
 #define print_creation_date printcreationdate
 #define write_zip writezip
 #define read_config_file readconfigfile
@@ -54,7 +54,8 @@ Lexer::Lexer(XRef *xref, Stream *str) {
   streams->add(curStr.copy(&obj));
   strPtr = 0;
   freeArray = gTrue;
-  curStr.streamReset();
+  bufPtr = bufEnd = buf;
+  startStream();
 }
 
 Lexer::Lexer(XRef *xref, Object *obj) {
@@ -69,9 +70,10 @@ Lexer::Lexer(XRef *xref, Object *obj) {
     freeArray = gFalse;
   }
   strPtr = 0;
+  bufPtr = bufEnd = buf;
   if (streams->getLength() > 0) {
     streams->get(strPtr, &curStr);
-    curStr.streamReset();
+    startStream();
   }
 }
 
@@ -85,27 +87,61 @@ Lexer::~Lexer() {
   }
 }
 
-int Lexer::getChar() {
-  int c;
+// Reset the current stream.  Base streams (files and memory) are read
+// a block at a time into buf; filtered streams are read a char at a
+// time, since their positions cannot be set back.
+void Lexer::startStream() {
+  curStr.streamReset();
+  buffered = curStr.getStream()->getBaseStream() == curStr.getStream();
+}
 
-  c = EOF;
-  while (!curStr.isNone() && (c = curStr.streamGetChar()) == EOF) {
+// Called by getChar() and lookChar() when buf is empty.  At the end
+// of a stream getChar() moves on to the next stream, but lookChar()
+// returns EOF, so that no token runs across the boundary.
+int Lexer::fillBuf(GBool advance) {
+  int c, n;
+
+  while (!curStr.isNone()) {
+    if (buffered) {
+      n = curStr.getStream()->getBlock(buf, lexBufSize);
+      bufPtr = buf;
+      bufEnd = buf + n;
+      if (n > 0) {
+	c = *bufPtr & 0xff;
+	if (advance) {
+	  ++bufPtr;
+	}
+	return c;
+      }
+    } else {
+      c = advance ? curStr.streamGetChar() : curStr.streamLookChar();
+      if (c != EOF) {
+	return c;
+      }
+    }
+    if (!advance) {
+      break;
+    }
     curStr.streamClose();
     curStr.free();
     ++strPtr;
     if (strPtr < streams->getLength()) {
       streams->get(strPtr, &curStr);
-      curStr.streamReset();
+      startStream();
     }
   }
-  return c;
+  return EOF;
 }
 
-int Lexer::lookChar() {
+Stream *Lexer::getStream() {
   if (curStr.isNone()) {
-    return EOF;
+    return NULL;
+  }
+  if (bufPtr < bufEnd) {
+    curStr.streamSetPos(getPos());
+    bufPtr = bufEnd = buf;
   }
-  return curStr.streamLookChar();
+  return curStr.getStream();
 }
 
 Object *Lexer::getObj(Object *obj) {
@@ -21,6 +21,7 @@
 class XRef;
 
 #define tokBufSize 128		// size of token buffer
+#define lexBufSize 1024		// size of input buffer
 
 //------------------------------------------------------------------------
 // Lexer
@@ -49,29 +50,39 @@ public:
   // Skip over one character.
   void skipChar() { getChar(); }
 
-  // Get stream.
-  Stream *getStream()
-    { return curStr.isNone() ? (Stream *)NULL : curStr.getStream(); }
+  // Get stream.  Its position is that of the next char the lexer
+  // would return.
+  Stream *getStream();
 
   // Get current position in file.  This is only used for error
   // messages, so it returns an int instead of a Guint.
   int getPos()
-    { return curStr.isNone() ? -1 : (int)curStr.streamGetPos(); }
+    { return curStr.isNone() ? -1
+	                      : (int)curStr.streamGetPos() - (bufEnd - bufPtr); }
 
   // Set position in file.
   void setPos(Guint pos, int dir = 0)
-    { if (!curStr.isNone()) curStr.streamSetPos(pos, dir); }
+    { if (!curStr.isNone()) { bufPtr = bufEnd = buf;
+                              curStr.streamSetPos(pos, dir); } }
 
 private:
 
-  int getChar();
-  int lookChar();
+  int getChar()
+    { return (bufPtr < bufEnd) ? (*bufPtr++ & 0xff) : fillBuf(gTrue); }
+  int lookChar()
+    { return (bufPtr < bufEnd) ? (*bufPtr & 0xff) : fillBuf(gFalse); }
+  int fillBuf(GBool advance);
+  void startStream();
 
   Array *streams;		// array of input streams
   int strPtr;			// index of current stream
   Object curStr;		// current stream
   GBool freeArray;		// should lexer free the streams array?
   char tokBuf[tokBufSize];	// temporary token buffer
+  GBool buffered;		// is the current stream read into buf?
+  char buf[lexBufSize];		// input buffer
+  char *bufPtr;			// next char in buf
+  char *bufEnd;			// end of the chars in buf
 };
 
 #endif
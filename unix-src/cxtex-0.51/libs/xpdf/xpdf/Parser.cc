@@ -155,6 +155,15 @@ Object *Parser::getObj(Object *obj) {
   return obj;
 }
 
+void Parser::setPos(Guint pos) {
+  lexer->setPos(pos);
+  inlineImg = 0;
+  buf1.free();
+  buf2.free();
+  lexer->getObj(&buf1);
+  lexer->getObj(&buf2);
+}
+
 Stream *Parser::makeStream(Object *dict) {
   Object obj;
   Stream *str;
@@ -176,7 +185,8 @@ Stream *Parser::makeStream(Object *dict) {
   }
 
   // check for length in damaged file
-  if (xref->getStreamEnd(pos, &endPos)) {
+  // (there is no xref while a cross-reference stream is being read)
+  if (xref && xref->getStreamEnd(pos, &endPos)) {
     length = endPos - pos;
   }
 
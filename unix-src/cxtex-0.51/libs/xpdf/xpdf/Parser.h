@@ -45,6 +45,9 @@ public:
   // Get current position in file.
   int getPos() { return lexer->getPos(); }
 
+  // Continue parsing at position <pos> in the file.
+  void setPos(Guint pos);
+
 private:
 
   XRef *xref;			// the xref table for this PDF file
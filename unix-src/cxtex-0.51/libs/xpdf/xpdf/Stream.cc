@@ -20,6 +20,7 @@
 #endif
 #include <string.h>
 #include <ctype.h>
+#include <zlib.h>
 #include "gmem.h"
 #include "gfile.h"
 #include "config.h"
@@ -84,6 +85,17 @@ char *Stream::getLine(char *buf, int size) {
   return buf;
 }
 
+int Stream::getBlock(char *blk, int size) {
+  int n, c;
+
+  for (n = 0; n < size; ++n) {
+    if ((c = getChar()) == EOF)
+      break;
+    blk[n] = (char)c;
+  }
+  return n;
+}
+
 GString *Stream::getPSFilter(char *indent) {
   return new GString();
 }
@@ -614,9 +626,6 @@ void FileStream::close() {
 
 GBool FileStream::fillBuf() {
   int n;
-#ifndef NO_DECRYPTION
-  char *p;
-#endif
 
   bufPos += bufEnd - buf;
   bufPtr = bufEnd = buf;
@@ -633,14 +642,63 @@ GBool FileStream::fillBuf() {
   if (bufPtr >= bufEnd) {
     return gFalse;
   }
+  decryptBlock(buf, bufEnd);
+  return gTrue;
+}
+
+void FileStream::decryptBlock(char *p, char *end) {
 #ifndef NO_DECRYPTION
   if (decrypt) {
-    for (p = buf; p < bufEnd; ++p) {
+    for (; p < end; ++p) {
       *p = (char)decrypt->decryptByte((Guchar)*p);
     }
   }
 #endif
-  return gTrue;
+}
+
+// Whatever is left in the buffer is copied first; large requests are
+// then read straight into <blk>, bypassing the buffer.
+int FileStream::getBlock(char *blk, int size) {
+  int n, m;
+
+  n = 0;
+  while (n < size) {
+    if (bufPtr >= bufEnd) {
+      if (size - n < fileStreamBufSize) {
+	if (!fillBuf()) {
+	  break;
+	}
+      } else {
+	bufPos += bufEnd - buf;
+	bufPtr = bufEnd = buf;
+	m = size - n;
+	if (limited) {
+	  if (bufPos >= start + length) {
+	    break;
+	  }
+	  if (bufPos + m > start + length) {
+	    m = start + length - bufPos;
+	  }
+	}
+	m = fread(blk + n, 1, m, f);
+	if (m <= 0) {
+	  break;
+	}
+	decryptBlock(blk + n, blk + n + m);
+	bufPos += m;
+	n += m;
+	continue;
+      }
+    }
+    m = bufEnd - bufPtr;
+    if (m > size - n) {
+      m = size - n;
+    }
+    memcpy(blk + n, bufPtr, m);
+    bufPtr += m;
+    n += m;
+  }
+  return n;
 }
 
 void FileStream::setPos(Guint pos, int dir) {
@@ -735,6 +793,18 @@ void MemStream::reset() {
 void MemStream::close() {
 }
 
+int MemStream::getBlock(char *blk, int size) {
+  int n;
+
+  n = bufEnd - bufPtr;
+  if (n > size) {
+    n = size;
+  }
+  memcpy(blk, bufPtr, n);
+  bufPtr += n;
+  return n;
+}
+
 void MemStream::setPos(Guint pos, int dir) {
   if (dir >= 0) {
     if (pos > length) {
@@ -3187,9 +3257,15 @@ FlateStream::FlateStream(Stream *strA, int predictor, int columns,
   }
   litCodeTab.codes = NULL;
   distCodeTab.codes = NULL;
+  zstr = NULL;
+  useZlib = gFalse;
 }
 
 FlateStream::~FlateStream() {
+  if (zstr) {
+    inflateEnd(zstr);
+    gfree(zstr);
+  }
   gfree(litCodeTab.codes);
   gfree(distCodeTab.codes);
   if (pred) {
@@ -3208,6 +3284,7 @@ void FlateStream::reset() {
   compressedBlock = gFalse;
   endOfBlock = gTrue;
   eof = gTrue;
+  useZlib = gFalse;
 
   str->reset();
 
@@ -3232,6 +3309,28 @@ void FlateStream::reset() {
   }
 
   eof = gFalse;
+
+  // zlib inflates the raw deflate data (its header has been read
+  // above); the decoder below only takes over from it if the data turn
+  // out to be damaged, see restartDecoder()
+  if (!zstr) {
+    zstr = (z_stream *)gmalloc(sizeof(z_stream));
+    zstr->zalloc = Z_NULL;
+    zstr->zfree = Z_NULL;
+    zstr->opaque = Z_NULL;
+    if (inflateInit2(zstr, -MAX_WBITS) != Z_OK) {
+      gfree(zstr);
+      zstr = NULL;
+    }
+  } else {
+    inflateReset(zstr);
+  }
+  if (zstr) {
+    zstr->next_in = inBuf;
+    zstr->avail_in = 0;
+    useZlib = gTrue;
+  }
+  outCount = 0;
 }
 
 int FlateStream::getChar() {
@@ -3280,6 +3379,36 @@ int FlateStream::getRawChar() {
   return c;
 }
 
+int FlateStream::getBlock(char *blk, int size) {
+  int n, m;
+
+  if (pred) {
+    return Stream::getBlock(blk, size);
+  }
+  n = 0;
+  while (n < size) {
+    if (remain == 0) {
+      if (endOfBlock && eof) {
+	break;
+      }
+      readSome();
+      continue;
+    }
+    m = flateWindow - index;
+    if (m > remain) {
+      m = remain;
+    }
+    if (m > size - n) {
+      m = size - n;
+    }
+    memcpy(blk + n, buf + index, m);
+    index = (index + m) & flateMask;
+    remain -= m;
+    n += m;
+  }
+  return n;
+}
+
 GString *FlateStream::getPSFilter(char *indent) {
   return NULL;
 }
@@ -3288,12 +3417,79 @@ GBool FlateStream::isBinary(GBool last) {
   return str->isBinary(gTrue);
 }
 
+// Inflate the next piece of data with zlib into buf.  Returns false,
+// having delivered nothing, if the data are damaged or end early.
+GBool FlateStream::inflateSome() {
+  int n, r;
+
+  zstr->next_out = buf;
+  zstr->avail_out = flateWindow;
+  do {
+    if (zstr->avail_in == 0) {
+      zstr->next_in = inBuf;
+      zstr->avail_in = str->getBlock((char *)inBuf, flateInBufSize);
+    }
+    r = inflate(zstr, Z_NO_FLUSH);
+  } while (r == Z_OK && zstr->avail_out == flateWindow);
+  n = flateWindow - zstr->avail_out;
+  if (r == Z_STREAM_END) {
+    endOfBlock = eof = gTrue;
+  } else if (r != Z_OK && n == 0) {
+    return gFalse;
+  }
+  index = 0;
+  remain = n;
+  outCount += n;
+  return gTrue;
+}
+
+// zlib has found the data damaged: decode them again from the start
+// with the decoder below, which copes with damage as it always has
+// (error messages included), and skip what zlib has delivered.  The
+// window is cleared, so that references before the start of the data
+// read zeros rather than what zlib left there.
+void FlateStream::restartDecoder() {
+  Guint skip;
+  int n;
+
+  useZlib = gFalse;
+  memset(buf, 0, flateWindow);
+  index = 0;
+  remain = 0;
+  codeBuf = 0;
+  codeSize = 0;
+  compressedBlock = gFalse;
+  endOfBlock = gTrue;
+  eof = gFalse;
+  str->reset();
+  str->getChar();
+  str->getChar();
+  for (skip = outCount; skip > 0; skip -= n) {
+    while (remain == 0) {
+      if (endOfBlock && eof) {
+	return;
+      }
+      readSome();
+    }
+    n = remain < (int)skip ? remain : (int)skip;
+    index = (index + n) & flateMask;
+    remain -= n;
+  }
+}
+
 void FlateStream::readSome() {
   int code1, code2;
   int len, dist;
   int i, j, k;
   int c;
 
+  if (useZlib) {
+    if (!inflateSome()) {
+      restartDecoder();
+    }
+    return;
+  }
+
   if (endOfBlock) {
     if (!startBlock())
       return;
@@ -3416,6 +3612,80 @@ err:
   return gFalse;
 }
 
+void FlateStream::getBitPos(Guint *pos, int *bit) {
+  *pos = (Guint)str->getPos() - (codeSize + 7) / 8;
+  *bit = (8 - codeSize % 8) % 8;
+}
+
+GBool FlateStream::skim(FlateExtent *ext) {
+  Guint length, pos;
+  int code1, code2, len, dist, bit;
+
+  if (pred) {
+    return gFalse;
+  }
+  reset();
+  if (eof) {
+    return gFalse;
+  }
+  useZlib = gFalse;
+  length = 0;
+  while (!eof) {
+    getBitPos(&ext->lastBlockPos, &ext->lastBlockBit);
+    if (!startBlock()) {
+      return gFalse;
+    }
+    if (compressedBlock) {
+      while ((code1 = getHuffmanCodeWord(&litCodeTab)) != 256) {
+	if (code1 < 256) {
+	  if (code1 == EOF) {
+	    return gFalse;
+	  }
+	  ++length;
+	  continue;
+	}
+	code1 -= 257;
+	if (code1 > 28) {
+	  return gFalse;
+	}
+	code2 = lengthDecode[code1].bits;
+	if (code2 > 0 && (code2 = getCodeWord(code2)) == EOF) {
+	  return gFalse;
+	}
+	len = lengthDecode[code1].first + code2;
+	if ((code1 = getHuffmanCodeWord(&distCodeTab)) == EOF) {
+	  return gFalse;
+	}
+	code2 = distDecode[code1].bits;
+	if (code2 > 0 && (code2 = getCodeWord(code2)) == EOF) {
+	  return gFalse;
+	}
+	dist = distDecode[code1].first + code2;
+	if ((Guint)dist > length) {
+	  return gFalse;
+	}
+	length += len;
+      }
+    } else {
+      // startBlock assumes that the rest of the header byte is padding
+      getBitPos(&pos, &bit);
+      if (pos != ext->lastBlockPos + ((ext->lastBlockBit + 3 + 7) / 8) + 4) {
+	return gFalse;
+      }
+      for (; blockLen > 0; --blockLen, ++length) {
+	if (str->getChar() == EOF) {
+	  return gFalse;
+	}
+      }
+    }
+  }
+  getBitPos(&ext->endPos, &ext->endBit);
+  ext->length = length;
+  endOfBlock = gTrue;
+  remain = 0;
+  return gTrue;
+}
+
 void FlateStream::loadFixedCodes() {
   int i;
 
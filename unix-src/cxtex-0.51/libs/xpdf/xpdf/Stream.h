@@ -78,6 +78,10 @@ public:
   // Get next line from stream.
   virtual char *getLine(char *buf, int size);
 
+  // Get up to <size> chars from stream into <blk>; returns the number
+  // of chars read, which is less than <size> only at the end.
+  virtual int getBlock(char *blk, int size);
+
   // Get current position in file.
   virtual int getPos() = 0;
 
@@ -265,6 +269,7 @@ public:
     { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr++ & 0xff); }
   virtual int lookChar()
     { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr & 0xff); }
+  virtual int getBlock(char *blk, int size);
   virtual int getPos() { return bufPos + (bufPtr - buf); }
   virtual void setPos(Guint pos, int dir = 0);
   virtual GBool isBinary(GBool last = gTrue) { return last; }
@@ -274,6 +279,7 @@ public:
 private:
 
   GBool fillBuf();
+  void decryptBlock(char *p, char *end);
 
   FILE *f;
   Guint start;
@@ -305,6 +311,7 @@ public:
     { return (bufPtr < bufEnd) ? (*bufPtr++ & 0xff) : EOF; }
   virtual int lookChar()
     { return (bufPtr < bufEnd) ? (*bufPtr & 0xff) : EOF; }
+  virtual int getBlock(char *blk, int size);
   virtual int getPos() { return bufPtr - buf; }
   virtual void setPos(Guint pos, int dir = 0);
   virtual GBool isBinary(GBool last = gTrue) { return last; }
@@ -634,6 +641,7 @@ private:
 #define flateMaxCodeLenCodes    19    // max # code length codes
 #define flateMaxLitCodes       288    // max # literal codes
 #define flateMaxDistCodes       30    // max # distance codes
+#define flateInBufSize       16384    // zlib input buffer size
 
 // Huffman code table entry
 struct FlateCode {
@@ -652,6 +660,17 @@ struct FlateDecode {
   int first;			// first length/distance
 };
 
+// Where the deflate data of a flate stream lie in the underlying
+// stream, as found by FlateStream::skim.  Positions are those of the
+// underlying stream; bits are numbered from the least significant.
+struct FlateExtent {
+  Guint lastBlockPos;		// byte holding the final block's header
+  int lastBlockBit;		//   bit of the BFINAL flag in it
+  Guint endPos;			// byte holding the first bit after the data
+  int endBit;			//   that bit (0 if the data end on a byte)
+  Guint length;			// length of the decoded data
+};
+
 class FlateStream: public FilterStream {
 public:
 
@@ -663,9 +682,15 @@ public:
   virtual int getChar();
   virtual int lookChar();
   virtual int getRawChar();
+  virtual int getBlock(char *blk, int size);
   virtual GString *getPSFilter(char *indent);
   virtual GBool isBinary(GBool last = gTrue);
 
+  // Walk through the deflate blocks without producing any output, and
+  // fill in <ext>.  Returns false if the data are damaged, refer back
+  // beyond their own start, or need a predictor.
+  GBool skim(FlateExtent *ext);
+
 private:
 
   StreamPredictor *pred;	// predictor
@@ -682,6 +707,10 @@ private:
   int blockLen;			// remaining length of uncompressed block
   GBool endOfBlock;		// set when end of block is reached
   GBool eof;			// set when end of stream is reached
+  struct z_stream_s *zstr;	// zlib inflater
+  GBool useZlib;		// set while zlib does the inflating
+  Guint outCount;		// number of bytes inflated by zlib
+  Guchar inBuf[flateInBufSize];	// zlib input buffer
 
   static int			// code length code reordering
     codeLenCodeMap[flateMaxCodeLenCodes];
@@ -691,7 +720,10 @@ private:
     distDecode[flateMaxDistCodes];
 
   void readSome();
+  GBool inflateSome();
+  void restartDecoder();
   GBool startBlock();
+  void getBitPos(Guint *pos, int *bit);
   void loadFixedCodes();
   GBool readDynamicCodes();
   void compHuffmanCodes(int *lengths, int n, FlateHuffmanTab *tab);
@@ -46,6 +46,138 @@
 #define defPermFlags 0xfffc
 #endif
 
+//------------------------------------------------------------------------
+// ObjectStream
+//------------------------------------------------------------------------
+
+// A PDF 1.5 object stream.  The stream is decoded once and the data
+// kept, so that fetching the objects in it doesn't inflate it again;
+// the objects themselves are parsed from the data on demand.
+class ObjectStream {
+public:
+
+  ObjectStream(XRef *xrefA, int objStrNumA);
+  ~ObjectStream();
+
+  GBool isOk() { return nObjects > 0; }
+  int getObjStrNum() { return objStrNum; }
+
+  // Parse object <objNum>, which is stored at index <objIdx>.
+  Object *getObject(int objIdx, int objNum, Object *obj);
+
+private:
+
+  XRef *xref;			// the xref table
+  int objStrNum;		// number of the object stream
+  char *buf;			// decoded stream data
+  int len;			// number of bytes in buf
+  int nObjects;			// number of objects in the stream
+  int *objNums;			// object numbers
+  int *offsets;			// offsets of the objects in buf
+};
+
+ObjectStream::ObjectStream(XRef *xrefA, int objStrNumA) {
+  Parser *parser;
+  Object objStr, obj1, obj2;
+  int n, first, bufSize, i;
+
+  xref = xrefA;
+  objStrNum = objStrNumA;
+  buf = NULL;
+  len = 0;
+  nObjects = 0;
+  objNums = NULL;
+  offsets = NULL;
+
+  if (!xref->fetch(objStrNum, 0, &objStr)->isStream()) {
+    goto err1;
+  }
+  if (!objStr.streamGetDict()->lookup("N", &obj1)->isInt()) {
+    goto err2;
+  }
+  n = obj1.getInt();
+  obj1.free();
+  if (!objStr.streamGetDict()->lookup("First", &obj1)->isInt()) {
+    goto err2;
+  }
+  first = obj1.getInt();
+  obj1.free();
+  if (n <= 0 || first < 0) {
+    goto err1;
+  }
+
+  // decode the stream
+  objStr.streamReset();
+  bufSize = 0;
+  do {
+    if (len == bufSize) {
+      bufSize += 16384;
+      buf = (char *)grealloc(buf, bufSize);
+    }
+    i = objStr.getStream()->getBlock(buf + len, bufSize - len);
+    len += i;
+  } while (i > 0);
+  objStr.streamClose();
+  if (first > len) {
+    goto err1;
+  }
+
+  // read the object numbers and offsets from the header
+  objNums = (int *)gmalloc(n * sizeof(int));
+  offsets = (int *)gmalloc(n * sizeof(int));
+  obj1.initNull();
+  parser = new Parser(NULL,
+	     new Lexer(NULL, new MemStream(buf, first, &obj1)));
+  for (i = 0; i < n; ++i) {
+    parser->getObj(&obj1);
+    parser->getObj(&obj2);
+    if (!obj1.isInt() || !obj2.isInt() ||
+	obj2.getInt() < 0 || obj2.getInt() > len - first) {
+      obj1.free();
+      obj2.free();
+      delete parser;
+      goto err1;
+    }
+    objNums[i] = obj1.getInt();
+    offsets[i] = first + obj2.getInt();
+    obj1.free();
+    obj2.free();
+  }
+  delete parser;
+  nObjects = n;
+  objStr.free();
+  return;
+
+ err2:
+  obj1.free();
+ err1:
+  error(-1, "Bad object stream %d", objStrNum);
+  objStr.free();
+}
+
+ObjectStream::~ObjectStream() {
+  gfree(buf);
+  gfree(objNums);
+  gfree(offsets);
+}
+
+Object *ObjectStream::getObject(int objIdx, int objNum, Object *obj) {
+  Parser *parser;
+  Object obj1;
+
+  if (objIdx < 0 || objIdx >= nObjects || objNums[objIdx] != objNum) {
+    return obj->initNull();
+  }
+  obj1.initNull();
+  parser = new Parser(xref,
+	     new Lexer(xref,
+	       new MemStream(buf + offsets[objIdx], len - offsets[objIdx],
+			     &obj1)));
+  parser->getObj(obj);
+  delete parser;
+  return obj;
+}
+
 //------------------------------------------------------------------------
 // XRef
 //------------------------------------------------------------------------
@@ -60,6 +192,12 @@ XRef::XRef(BaseStream *strA, GString *ownerPassword, GString *userPassword) {
   entries = NULL;
   streamEnds = NULL;
   streamEndsLen = 0;
+  objStrsLen = 0;
+  for (i = 0; i < objCacheSize; ++i) {
+    objCache[i].num = -1;
+  }
+  parser = NULL;
+  parserBusy = gFalse;
 
   // read the trailer
   str = strA;
@@ -79,7 +217,8 @@ XRef::XRef(BaseStream *strA, GString *ownerPassword, GString *userPassword) {
     entries = (XRefEntry *)gmalloc(size * sizeof(XRefEntry));
     for (i = 0; i < size; ++i) {
       entries[i].offset = 0xffffffff;
-      entries[i].used = gFalse;
+      entries[i].gen = 0;
+      entries[i].type = xrefEntryFree;
     }
     while (readXRef(&pos)) ;
 
@@ -112,6 +251,15 @@ XRef::XRef(BaseStream *strA, GString *ownerPassword, GString *userPassword) {
 }
 
 XRef::~XRef() {
+  int i;
+
+  for (i = 0; i < objStrsLen; ++i) {
+    delete objStrs[i];
+  }
+  for (i = 0; i < objCacheSize; ++i) {
+    objCache[i].obj.free();
+  }
+  delete parser;
   gfree(entries);
   trailerDict.free();
   if (streamEnds) {
@@ -123,7 +271,8 @@ XRef::~XRef() {
 // first xref position.
 Guint XRef::readTrailer() {
   Parser *parser;
-  Object obj;
+  Object obj, obj2;
+  Dict *dict;
   char buf[xrefSearchSize+1];
   int n;
   Guint pos, pos1;
@@ -156,37 +305,53 @@ Guint XRef::readTrailer() {
   str->setPos(start + pos);
   for (i = 0; i < 4; ++i)
     buf[i] = str->getChar();
-  if (strncmp(buf, "xref", 4))
-    return 0;
-  pos1 = pos + 4;
-  while (1) {
-    str->setPos(start + pos1);
-    for (i = 0; i < 35; ++i) {
-      if ((c = str->getChar()) == EOF)
+  if (!strncmp(buf, "xref", 4)) {
+    pos1 = pos + 4;
+    while (1) {
+      str->setPos(start + pos1);
+      for (i = 0; i < 35; ++i) {
+	if ((c = str->getChar()) == EOF)
+	  return 0;
+	buf[i] = c;
+      }
+      if (!strncmp(buf, "trailer", 7))
+	break;
+      p = buf;
+      while (isspace(*p)) ++p;
+      while ('0' <= *p && *p <= '9') ++p;
+      while (isspace(*p)) ++p;
+      n = atoi(p);
+      while ('0' <= *p && *p <= '9') ++p;
+      while (isspace(*p)) ++p;
+      if (p == buf)
 	return 0;
-      buf[i] = c;
+      pos1 += (p - buf) + n * 20;
     }
-    if (!strncmp(buf, "trailer", 7))
-      break;
-    p = buf;
-    while (isspace(*p)) ++p;
-    while ('0' <= *p && *p <= '9') ++p;
-    while (isspace(*p)) ++p;
-    n = atoi(p);
-    while ('0' <= *p && *p <= '9') ++p;
-    while (isspace(*p)) ++p;
-    if (p == buf)
+    pos1 += 7;
+
+    // read trailer dict
+    obj.initNull();
+    parser = new Parser(NULL,
+	       new Lexer(NULL,
+		 str->makeSubStream(start + pos1, gFalse, 0, &obj)));
+    parser->getObj(&trailerDict);
+    delete parser;
+
+  // no table: a PDF 1.5 cross-reference stream, whose dictionary
+  // doubles as the trailer dict
+  } else {
+    if (!getXRefStream(pos, &obj)) {
+      obj.free();
       return 0;
-    pos1 += (p - buf) + n * 20;
+    }
+    dict = obj.streamGetDict();
+    trailerDict.initDict((XRef *)NULL);
+    for (i = 0; i < dict->getLength(); ++i) {
+      trailerDict.dictAdd(copyString(dict->getKey(i)),
+			  dict->getValNF(i, &obj2));
+    }
+    obj.free();
   }
-  pos1 += 7;
-
-  // read trailer dict
-  obj.initNull();
-  parser = new Parser(NULL,
-	     new Lexer(NULL,
-	       str->makeSubStream(start + pos1, gFalse, 0, &obj)));
-  parser->getObj(&trailerDict);
   if (trailerDict.isDict()) {
     trailerDict.dictLookupNF("Size", &obj);
     if (obj.isInt())
@@ -205,26 +370,37 @@ Guint XRef::readTrailer() {
   } else {
     pos = 0;
   }
-  delete parser;
 
   // return first xref position
   return pos;
 }
 
-// Read an xref table and the prev pointer from the trailer.
+// Read an xref table and the prev pointer from the trailer, or a
+// cross-reference stream and its prev pointer.
 GBool XRef::readXRef(Guint *pos) {
   Parser *parser;
   Object obj, obj2;
   char s[20];
   GBool more;
-  int first, newSize, n, i, j;
+  int first, n, i, j;
   int c;
+  Guint streamPos;
 
   // seek to xref in stream
   str->setPos(start + *pos);
 
-  // make sure it's an xref table
+  // a cross-reference stream starts with its object number
   while ((c = str->getChar()) != EOF && isspace(c)) ;
+  if (isdigit(c)) {
+    if (!getXRefStream(*pos, &obj)) {
+      goto err1;
+    }
+    more = readXRefStream(obj.getStream(), pos, gFalse);
+    obj.free();
+    return more;
+  }
+
+  // make sure it's an xref table
   s[0] = (char)c;
   s[1] = (char)str->getChar();
   s[2] = (char)str->getChar();
@@ -266,13 +442,7 @@ GBool XRef::readXRef(Guint *pos) {
     // check for buggy PDF files with an incorrect (too small) xref
     // table size
     if (first + n > size) {
-      newSize = size + 256;
-      entries = (XRefEntry *)grealloc(entries, newSize * sizeof(XRefEntry));
-      for (i = size; i < newSize; ++i) {
-	entries[i].offset = 0xffffffff;
-	entries[i].used = gFalse;
-      }
-      size = newSize;
+      growEntries(size + 256);
     }
     for (i = first; i < first + n; ++i) {
       for (j = 0; j < 20; ++j) {
@@ -287,9 +457,9 @@ GBool XRef::readXRef(Guint *pos) {
 	s[16] = '\0';
 	entries[i].gen = atoi(&s[11]);
 	if (s[17] == 'n') {
-	  entries[i].used = gTrue;
+	  entries[i].type = xrefEntryUncompressed;
 	} else if (s[17] == 'f') {
-	  entries[i].used = gFalse;
+	  entries[i].type = xrefEntryFree;
 	} else {
 	  goto err2;
 	}
@@ -298,7 +468,7 @@ GBool XRef::readXRef(Guint *pos) {
 	// instead of 0.
 	if (i == 1 && first == 1 &&
 	    entries[1].offset == 0 && entries[1].gen == 65535 &&
-	    !entries[1].used) {
+	    entries[1].type == xrefEntryFree) {
 	  i = first = 0;
 	  entries[0] = entries[1];
 	  entries[1].offset = 0xffffffff;
@@ -333,10 +503,129 @@ GBool XRef::readXRef(Guint *pos) {
   } else {
     more = gFalse;
   }
+  obj2.free();
+
+  // the table of a hybrid file is supplemented by a cross-reference
+  // stream, which lists the compressed objects
+  obj.getDict()->lookupNF("XRefStm", &obj2);
   obj.free();
+  delete parser;
+  if (obj2.isInt()) {
+    streamPos = (Guint)obj2.getInt();
+    if (getXRefStream(streamPos, &obj)) {
+      readXRefStream(obj.getStream(), &streamPos, gTrue);
+    }
+    obj.free();
+  }
   obj2.free();
 
+  return more;
+
+ err1:
+  obj.free();
+ err2:
+  ok = gFalse;
+  return gFalse;
+}
+
+// Read the cross-reference stream object at <pos>.  It is parsed
+// without an xref: its dictionary may not use indirect references.
+GBool XRef::getXRefStream(Guint pos, Object *obj) {
+  Parser *parser;
+  Object obj1, obj2, obj3;
+
+  obj1.initNull();
+  parser = new Parser(NULL,
+	     new Lexer(NULL,
+	       str->makeSubStream(start + pos, gFalse, 0, &obj1)));
+  parser->getObj(&obj1);
+  parser->getObj(&obj2);
+  parser->getObj(&obj3);
+  if (obj1.isInt() && obj2.isInt() && obj3.isCmd("obj")) {
+    parser->getObj(obj);
+  } else {
+    obj->initNull();
+  }
+  obj1.free();
+  obj2.free();
+  obj3.free();
   delete parser;
+  return obj->isStream() && obj->streamGetDict()->is("XRef");
+}
+
+// Read the entries of a cross-reference stream and its prev pointer.
+// <hybrid> is set for the /XRefStm stream of a hybrid file.
+GBool XRef::readXRefStream(Stream *xrefStr, Guint *pos, GBool hybrid) {
+  Dict *dict;
+  Object obj, obj2;
+  int w[3];
+  int newSize, first, n, i;
+  GBool more;
+
+  dict = xrefStr->getDict();
+  if (!dict->lookupNF("Size", &obj)->isInt()) {
+    goto err1;
+  }
+  newSize = obj.getInt();
+  obj.free();
+  if (newSize < 0) {
+    goto err2;
+  }
+  if (newSize > size) {
+    growEntries(newSize);
+  }
+
+  if (!dict->lookupNF("W", &obj)->isArray() || obj.arrayGetLength() < 3) {
+    goto err1;
+  }
+  for (i = 0; i < 3; ++i) {
+    if (!obj.arrayGet(i, &obj2)->isInt()) {
+      obj2.free();
+      goto err1;
+    }
+    w[i] = obj2.getInt();
+    obj2.free();
+    if (w[i] < 0 || w[i] > 4) {
+      goto err1;
+    }
+  }
+  obj.free();
+
+  xrefStr->reset();
+  if (dict->lookupNF("Index", &obj)->isArray()) {
+    for (i = 0; i + 1 < obj.arrayGetLength(); i += 2) {
+      if (!obj.arrayGet(i, &obj2)->isInt()) {
+	obj2.free();
+	goto err1;
+      }
+      first = obj2.getInt();
+      obj2.free();
+      if (!obj.arrayGet(i + 1, &obj2)->isInt()) {
+	obj2.free();
+	goto err1;
+      }
+      n = obj2.getInt();
+      obj2.free();
+      if (!readXRefStreamSection(xrefStr, w, first, n, hybrid)) {
+	goto err1;
+      }
+    }
+  } else {
+    if (!readXRefStreamSection(xrefStr, w, 0, newSize, hybrid)) {
+      goto err1;
+    }
+  }
+  obj.free();
+  xrefStr->close();
+
+  dict->lookupNF("Prev", &obj);
+  if (obj.isInt()) {
+    *pos = (Guint)obj.getInt();
+    more = gTrue;
+  } else {
+    more = gFalse;
+  }
+  obj.free();
   return more;
 
  err1:
@@ -346,6 +635,76 @@ GBool XRef::readXRef(Guint *pos) {
   return gFalse;
 }
 
+// Read <n> entries, starting with object <first>, from a
+// cross-reference stream whose fields are <w> bytes wide.
+GBool XRef::readXRefStreamSection(Stream *xrefStr, int *w, int first, int n,
+				  GBool hybrid) {
+  Guint offset;
+  int type, gen, c, i, j;
+
+  if (first < 0 || n < 0 || first + n < 0) {
+    return gFalse;
+  }
+  if (first + n > size) {
+    growEntries(first + n);
+  }
+  for (i = first; i < first + n; ++i) {
+    if (w[0] == 0) {
+      type = 1;
+    } else {
+      for (type = 0, j = 0; j < w[0]; ++j) {
+	if ((c = xrefStr->getChar()) == EOF) {
+	  return gFalse;
+	}
+	type = (type << 8) + c;
+      }
+    }
+    for (offset = 0, j = 0; j < w[1]; ++j) {
+      if ((c = xrefStr->getChar()) == EOF) {
+	return gFalse;
+      }
+      offset = (offset << 8) + c;
+    }
+    for (gen = 0, j = 0; j < w[2]; ++j) {
+      if ((c = xrefStr->getChar()) == EOF) {
+	return gFalse;
+      }
+      gen = (gen << 8) + c;
+    }
+    // newer sections win, except that the stream of a hybrid file
+    // fills in the objects its table marks as free
+    if (entries[i].offset == 0xffffffff ||
+	(hybrid && entries[i].type == xrefEntryFree)) {
+      entries[i].offset = offset;
+      entries[i].gen = gen;
+      switch (type) {
+      case 1:
+	entries[i].type = xrefEntryUncompressed;
+	break;
+      case 2:
+	entries[i].type = xrefEntryCompressed;
+	break;
+      default:			// unknown types are null references
+	entries[i].type = xrefEntryFree;
+	break;
+      }
+    }
+  }
+  return gTrue;
+}
+
+void XRef::growEntries(int newSize) {
+  int i;
+
+  entries = (XRefEntry *)grealloc(entries, newSize * sizeof(XRefEntry));
+  for (i = size; i < newSize; ++i) {
+    entries[i].offset = 0xffffffff;
+    entries[i].gen = 0;
+    entries[i].type = xrefEntryFree;
+  }
+  size = newSize;
+}
+
 // Attempt to construct an xref table for a damaged file.
 GBool XRef::constructXRef() {
   Parser *parser;
@@ -353,10 +712,8 @@ GBool XRef::constructXRef() {
   char buf[256];
   Guint pos;
   int num, gen;
-  int newSize;
   int streamEndsSize;
   char *p;
-  int i;
   GBool gotRoot;
 
   error(0, "PDF file is damaged - attempting to reconstruct xref table...");
@@ -414,19 +771,13 @@ GBool XRef::constructXRef() {
 	    } while (*p && isspace(*p));
 	    if (!strncmp(p, "obj", 3)) {
 	      if (num >= size) {
-		newSize = (num + 1 + 255) & ~255;
-		entries = (XRefEntry *)
-		            grealloc(entries, newSize * sizeof(XRefEntry));
-		for (i = size; i < newSize; ++i) {
-		  entries[i].offset = 0xffffffff;
-		  entries[i].used = gFalse;
-		}
-		size = newSize;
+		growEntries((num + 1 + 255) & ~255);
 	      }
-	      if (!entries[num].used || gen >= entries[num].gen) {
+	      if (entries[num].type == xrefEntryFree ||
+		  gen >= entries[num].gen) {
 		entries[num].offset = pos - start;
 		entries[num].gen = gen;
-		entries[num].used = gTrue;
+		entries[num].type = xrefEntryUncompressed;
 	      }
 	    }
 	  }
@@ -587,7 +938,9 @@ GBool XRef::okToAddNotes(GBool ignoreOwnerPW) {
 
 Object *XRef::fetch(int num, int gen, Object *obj) {
   XRefEntry *e;
-  Parser *parser;
+  XRefCacheEntry *c;
+  Parser *parser1;
+  ObjectStream *objStr;
   Object obj1, obj2, obj3;
 
   // check for bogus ref - this can happen in corrupted PDF files
@@ -596,23 +949,50 @@ Object *XRef::fetch(int num, int gen, Object *obj) {
     return obj;
   }
 
+  // recently fetched objects are shared instead of parsed again
+  c = &objCache[num % objCacheSize];
+  if (c->num == num && c->gen == gen) {
+    return c->obj.copy(obj);
+  }
+
   e = &entries[num];
-  if (e->gen == gen && e->offset != 0xffffffff) {
-    obj1.initNull();
-    parser = new Parser(this,
-	       new Lexer(this,
-		 str->makeSubStream(start + e->offset, gFalse, 0, &obj1)));
-    parser->getObj(&obj1);
-    parser->getObj(&obj2);
-    parser->getObj(&obj3);
+  if (e->type == xrefEntryCompressed) {
+    if (gen == 0 && (objStr = getObjectStream((int)e->offset))) {
+      objStr->getObject(e->gen, num, obj);
+    } else {
+      obj->initNull();
+    }
+  } else if (e->type == xrefEntryUncompressed && e->gen == gen) {
+    // reuse the parser, unless this fetch comes from inside another
+    // one (an indirect stream length)
+    if (parserBusy) {
+      obj1.initNull();
+      parser1 = new Parser(this,
+		  new Lexer(this,
+		    str->makeSubStream(start + e->offset, gFalse, 0, &obj1)));
+    } else {
+      if (parser) {
+	parser->setPos(start + e->offset);
+      } else {
+	obj1.initNull();
+	parser = new Parser(this,
+		   new Lexer(this,
+		     str->makeSubStream(start + e->offset, gFalse, 0, &obj1)));
+      }
+      parser1 = parser;
+      parserBusy = gTrue;
+    }
+    parser1->getObj(&obj1);
+    parser1->getObj(&obj2);
+    parser1->getObj(&obj3);
     if (obj1.isInt() && obj1.getInt() == num &&
 	obj2.isInt() && obj2.getInt() == gen &&
 	obj3.isCmd("obj")) {
 #ifndef NO_DECRYPTION
-      parser->getObj(obj, encrypted ? fileKey : (Guchar *)NULL, keyLength,
-		     num, gen);
+      parser1->getObj(obj, encrypted ? fileKey : (Guchar *)NULL, keyLength,
+		      num, gen);
 #else
-      parser->getObj(obj);
+      parser1->getObj(obj);
 #endif
     } else {
       obj->initNull();
@@ -620,13 +1000,63 @@ Object *XRef::fetch(int num, int gen, Object *obj) {
     obj1.free();
     obj2.free();
     obj3.free();
-    delete parser;
+    if (parser1 == parser) {
+      parserBusy = gFalse;
+    } else {
+      delete parser1;
+    }
   } else {
     obj->initNull();
   }
+
+  // streams are not kept: their holders would share the read position
+  if (!obj->isStream()) {
+    c->obj.free();
+    obj->copy(&c->obj);
+    c->num = num;
+    c->gen = gen;
+  }
   return obj;
 }
 
+// Return the decoded object stream <objStrNum>, from the cache if it
+// has been used recently.
+ObjectStream *XRef::getObjectStream(int objStrNum) {
+  ObjectStream *objStr;
+  int i;
+
+  for (i = 0; i < objStrsLen; ++i) {
+    if (objStrs[i]->getObjStrNum() == objStrNum) {
+      objStr = objStrs[i];
+      for (; i > 0; --i) {
+	objStrs[i] = objStrs[i-1];
+      }
+      objStrs[0] = objStr;
+      return objStr;
+    }
+  }
+
+  // object streams can't themselves be compressed
+  if (objStrNum < 0 || objStrNum >= size ||
+      entries[objStrNum].type != xrefEntryUncompressed) {
+    return NULL;
+  }
+  objStr = new ObjectStream(this, objStrNum);
+  if (!objStr->isOk()) {
+    delete objStr;
+    return NULL;
+  }
+  if (objStrsLen == objStrCacheSize) {
+    delete objStrs[--objStrsLen];
+  }
+  for (i = objStrsLen; i > 0; --i) {
+    objStrs[i] = objStrs[i-1];
+  }
+  objStrs[0] = objStr;
+  ++objStrsLen;
+  return objStr;
+}
+
 Object *XRef::getDocInfo(Object *obj) {
   return trailerDict.dictLookup("Info", obj);
 }
@@ -20,17 +20,35 @@
 
 class Dict;
 class Stream;
+class Parser;
+class ObjectStream;
 
 //------------------------------------------------------------------------
 // XRef
 //------------------------------------------------------------------------
 
+enum XRefEntryType {
+  xrefEntryFree,
+  xrefEntryUncompressed,
+  xrefEntryCompressed
+};
+
 struct XRefEntry {
-  Guint offset;
-  int gen;
-  GBool used;
+  Guint offset;			// file offset, or number of the object
+				//   stream holding a compressed object
+  int gen;			// generation, or index in the object stream
+  XRefEntryType type;
+};
+
+#define objStrCacheSize 16	// number of decoded object streams kept
+
+struct XRefCacheEntry {
+  int num, gen;			// object number and generation, or -1
+  Object obj;			// parsed object
 };
 
+#define objCacheSize 1024	// number of parsed objects kept
+
 class XRef {
 public:
 
@@ -103,6 +121,13 @@ private:
   Guint *streamEnds;		// 'endstream' positions - only used in
 				//   damaged files
   int streamEndsLen;		// number of valid entries in streamEnds
+  ObjectStream *objStrs[objStrCacheSize]; // decoded object streams, most
+				//   recently used first
+  int objStrsLen;		// number of valid entries in objStrs
+  XRefCacheEntry objCache[objCacheSize]; // recently fetched objects,
+				//   indexed by number mod objCacheSize
+  Parser *parser;		// parser reused for uncompressed objects
+  GBool parserBusy;		// true while <parser> is in use
 #ifndef NO_DECRYPTION
   GBool encrypted;		// true if file is encrypted
   int encVersion;		// encryption algorithm
@@ -115,6 +140,12 @@ private:
 
   Guint readTrailer();
   GBool readXRef(Guint *pos);
+  GBool readXRefStream(Stream *xrefStr, Guint *pos, GBool hybrid);
+  GBool readXRefStreamSection(Stream *xrefStr, int *w, int first, int n,
+			      GBool hybrid);
+  GBool getXRefStream(Guint pos, Object *obj);
+  void growEntries(int newSize);
+  ObjectStream *getObjectStream(int objStrNum);
   GBool constructXRef();
   GBool checkEncrypted(GString *ownerPassword, GString *userPassword);
   Guint strToUnsigned(char *s);
@@ -57,6 +57,40 @@ void *safe_realloc (void *orig, size_t newsize) {
   return test;
 }
 
+/* arena allocation, blocks are chained and freed in one go */
+
+void *arena_alloc (struct arena *a, size_t size) {
+  struct arenablock *b = a->block;
+  void *ret;
+  size = (size + 7) & ~(size_t)7;
+  if (b == NULL || b->used + size > b->size) {
+    size_t blocksize = (size > ARENA_BLOCKSIZE ? size : ARENA_BLOCKSIZE);
+    b = safe_malloc(sizeof(struct arenablock)+blocksize);
+    b->next = a->block;
+    b->size = blocksize;
+    b->used = 0;
+    a->block = b;
+  }
+  ret = b->data + b->used;
+  b->used += size;
+  return ret;
+}
+
+char *arena_strdup (struct arena *a, const char *s) {
+  size_t l = strlen(s)+1;
+  char *ret = arena_alloc(a,l);
+  memcpy(ret,s,l);
+  return ret;
+}
+
+void arena_free (struct arena *a) {
+  struct arenablock *b;
+  while ((b = a->block) != NULL) {
+    a->block = b->next;
+    safe_free(b);
+  }
+}
+
 #ifndef USE_KPSE
 #ifdef WIN32
 const char *kpsewhich = "kpsewhich.exe";
@@ -87,8 +121,11 @@ char *checked_path (char *path) {
     ret++;
   }
   ret--;
-  if (*ret != pathslash)
-    my_concat(&path,path,pathslash_string);
+  if (*ret != pathslash) {
+    ret = NULL; /* |path| is not ours to free */
+    my_concat(&ret,path,pathslash_string);
+    return ret;
+  }
   return path; 
 }
 
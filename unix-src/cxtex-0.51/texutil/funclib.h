@@ -7,6 +7,27 @@ extern void safe_free(void *a);
 extern void *safe_strdup (void *orig);
 extern void *safe_realloc (void *orig, size_t newsize);
 
+/* An arena hands out memory that is only given back all at once, by
+ * arena_free.  It is used for data that lives until a file is done with,
+ * like the register entries of texutil.
+ */
+#define ARENA_BLOCKSIZE 65536
+
+struct arenablock {
+  struct arenablock *next;
+  size_t size;
+  size_t used;
+  char data[];
+};
+
+struct arena {
+  struct arenablock *block;
+};
+
+extern void *arena_alloc (struct arena *a, size_t size);
+extern char *arena_strdup (struct arena *a, const char *s);
+extern void arena_free (struct arena *a);
+
 #if DEBUGMEM
 #define safe_fopen(a,b,c)  a = fopen(b,c); fprintf(stdout,"f %p open was %s (%s)\n",a,b,c)
 #define safe_fclose(a)     fprintf(stdout,"f %p close\n",a); fclose(a)
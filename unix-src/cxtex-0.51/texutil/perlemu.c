@@ -7,6 +7,10 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 #include "perlemu.h"
 
 #include "funclib.h"
@@ -84,6 +88,79 @@ char *readline (FILE *file, char **thebuffer) {
   return 0;
 }
 
+/* while (<FILE>) over a whole file, see perlemu.h */
+int map_textfile (struct textfile *f, const char *name) {
+  FILE *F;
+  size_t n;
+  f->data = NULL;
+  f->length = 0;
+  f->position = 0;
+  f->mapped = 0;
+  f->lastline = NULL;
+#ifndef WIN32
+  struct stat st;
+  int fd = open(name,O_RDONLY);
+  if (fd < 0)
+    return 0;
+  if (fstat(fd,&st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    f->data = mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+    if (f->data != MAP_FAILED) {
+      f->length = st.st_size;
+      f->mapped = 1;
+      close(fd);
+      return 1;
+    }
+    f->data = NULL;
+  }
+  close(fd);
+#endif
+  /* no mapping possible, read it all */
+  F = fopen(name,"r");
+  if (F == NULL)
+    return 0;
+  n = BUFSIZE;
+  f->data = safe_malloc(n);
+  while ((f->length += fread(f->data+f->length,1,n-f->length,F)) == n) {
+    n *= 2;
+    f->data = safe_realloc(f->data,n);
+  }
+  fclose(F);
+  return 1;
+}
+
+char *mapped_readline (struct textfile *f) {
+  char *line, *newline;
+  size_t rest;
+  if (f->position >= f->length)
+    return NULL;
+  line = f->data + f->position;
+  rest = f->length - f->position;
+  newline = memchr(line,'\n',rest);
+  if (newline != NULL) {
+    *newline = 0;
+    f->position += newline - line + 1;
+    return line;
+  }
+  /* there is no room to end the last line in place */
+  f->position = f->length;
+  f->lastline = safe_malloc(rest+1);
+  memcpy(f->lastline,line,rest);
+  f->lastline[rest] = 0;
+  return chomp(f->lastline);
+}
+
+void unmap_textfile (struct textfile *f) {
+#ifndef WIN32
+  if (f->mapped)
+    munmap(f->data,f->length);
+  else
+#endif
+    safe_free(f->data);
+  safe_free(f->lastline);
+  f->data = NULL;
+  f->lastline = NULL;
+}
+
 /* remove trailing crlf/newline */
 char *chomp (char *line) {
   if (!strlen(line)) 
@@ -172,7 +249,7 @@ unsigned cksum (char *line) {
   unsigned int s=0; 
   int r;
   while (*line) {
-    s += *line;
+    s += *line++;
   }
   r = (s & 0xffff) + ((s & 0xffffffff) >> 16);
   return (r & 0xffff) + (r >> 16);
@@ -181,36 +258,68 @@ unsigned cksum (char *line) {
 
 
 Hash make_hash (void) {
-  Hash memblock = safe_malloc(sizeof(HashItem)*HASHSIZE);
+  Hash hashtab = safe_malloc(sizeof(struct hash_table));
   int k;
-  for (k=0;k<HASHSIZE;k++) {
-    memblock[k] = NULL;
-  }
-  return memblock;
+  hashtab->nitems = 0;
+  hashtab->itemsize = HASHSIZE;
+  hashtab->items = safe_malloc(sizeof(struct hash_item)*hashtab->itemsize);
+  hashtab->mask = HASHSIZE-1;
+  hashtab->slots = safe_malloc(sizeof(int)*HASHSIZE);
+  for (k=0;k<HASHSIZE;k++)
+    hashtab->slots[k] = -1;
+  return hashtab;
 }
 
-unsigned id_hash (char *s) {
-  unsigned val;
-  for (val = 0; *s != 0; s++)
-    val = *s + 31 * val;
-  val =  val % HASHSIZE;
+/* FNV-1a */
+static unsigned id_hash (const char *s) {
+  unsigned val = 2166136261U;
+  for (; *s != 0; s++)
+    val = (val ^ (unsigned char)*s) * 16777619U;
   return val;
 }
 
-HashItem get_item (Hash hashtab, char *s) {
+/* the slot that has |s|, or the free slot where it belongs */
+static int find_slot (Hash hashtab, const char *s, unsigned hashval) {
+  unsigned k = hashval & hashtab->mask;
   HashItem np;
-  for (np = hashtab[id_hash(s)]; np != NULL; np = np->next) 
-    if (strcmp(np->name,s) == 0)
-      return np;
-  return NULL;
+  while (hashtab->slots[k] >= 0) {
+    np = &hashtab->items[hashtab->slots[k]];
+    if (np->hashval == hashval && strcmp(np->name,s) == 0)
+      break;
+    k = (k+1) & hashtab->mask;
+  }
+  return k;
+}
+
+static void grow_hash (Hash hashtab) {
+  unsigned size = (hashtab->mask+1)*2;
+  unsigned k;
+  int i;
+  safe_free(hashtab->slots);
+  hashtab->slots = safe_malloc(sizeof(int)*size);
+  hashtab->mask = size-1;
+  for (k=0;k<size;k++)
+    hashtab->slots[k] = -1;
+  for (i=0;i<hashtab->nitems;i++) {
+    k = hashtab->items[i].hashval & hashtab->mask;
+    while (hashtab->slots[k] >= 0)
+      k = (k+1) & hashtab->mask;
+    hashtab->slots[k] = i;
+  }
+}
+
+HashItem get_item (Hash hashtab, char *s) {
+  int k = find_slot(hashtab,s,id_hash(s));
+  if (hashtab->slots[k] < 0)
+    return NULL;
+  return &hashtab->items[hashtab->slots[k]];
 }
 
 void *do_get_value (Hash hashtab, char *s) {
-  HashItem np;
-  for (np = hashtab[id_hash(s)]; np != NULL; np = np->next) 
-    if (strcmp(np->name,s) == 0)
-      return (void *)np->value;
-  return NULL;
+  HashItem np = get_item(hashtab,s);
+  if (np == NULL)
+    return NULL;
+  return np->value;
 }
 
 char *hash_value (Hash hashtab, char *s) {
@@ -222,29 +331,42 @@ char *hash_value (Hash hashtab, char *s) {
 
 
 int keys (Hash hashtab,char * **thekeys) {
-  char * *mykeys = safe_malloc(sizeof(char *)*HASHSIZE);
+  char * *mykeys = safe_malloc(sizeof(char *)*(hashtab->nitems+1));
   int k;
-  int keycount = 0;
-  for (k=0;k<HASHSIZE;k++) {
-    if (hashtab[k] && hashtab[k]->name != NULL)
-      mykeys[keycount++] = safe_strdup(hashtab[k]->name);
-  }
+  for (k=0;k<hashtab->nitems;k++)
+    mykeys[k] = safe_strdup(hashtab->items[k].name);
+  mykeys[k] = NULL;
   *thekeys=mykeys;
-  return keycount;
+  return hashtab->nitems;
+}
+
+HashItem each (Hash hashtab, int *k) {
+  if (*k >= hashtab->nitems)
+    return NULL;
+  return &hashtab->items[(*k)++];
 }
 
 
 HashItem do_set_value (Hash hashtab, char *name, void *defn) {
   HashItem np;
-  unsigned hashval;
-  if ((np = get_item(hashtab,name)) == NULL) {
-    np = (HashItem) safe_malloc(sizeof(*np));
-    np->name = safe_strdup(name);
-    hashval = id_hash(name);
-    np->next = hashtab[hashval];
-    hashtab[hashval] = np;
-  } else {
+  unsigned hashval = id_hash(name);
+  int k = find_slot(hashtab,name,hashval);
+  if (hashtab->slots[k] >= 0) {
+    np = &hashtab->items[hashtab->slots[k]];
     safe_free(np->value);
+  } else {
+    if ((unsigned)(hashtab->nitems+1)*4 > (hashtab->mask+1)*3) {
+      grow_hash(hashtab);
+      k = find_slot(hashtab,name,hashval);
+    }
+    if (hashtab->nitems == hashtab->itemsize) {
+      hashtab->itemsize *= 2;
+      hashtab->items = safe_realloc(hashtab->items,sizeof(struct hash_item)*hashtab->itemsize);
+    }
+    np = &hashtab->items[hashtab->nitems];
+    np->name = safe_strdup(name);
+    np->hashval = hashval;
+    hashtab->slots[k] = hashtab->nitems++;
   }
   np->value = defn;
   return np;
@@ -303,7 +425,7 @@ char *words (char **restofline, char *split){
     *restofline = loc + strlen(split);
   } else {
     retval = *restofline;
-    *restofline = loc + strlen(retval);
+    *restofline = retval + strlen(retval);
   }
   return retval;
 }
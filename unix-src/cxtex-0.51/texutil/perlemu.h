@@ -16,6 +16,23 @@ extern char *strcasestr (char *haystack, char *needle);
 
 extern char *readline (FILE *file, char **thebuffer);
 
+/* A whole text file in memory, read line by line.  The file is mapped
+ * copy-on-write where possible, so lines are returned in place: they end
+ * where the newline was, can be modified, and stay valid until the file
+ * is unmapped.  There is no limit on the line length.
+ */
+struct textfile {
+  char *data;
+  size_t length;
+  size_t position;
+  int mapped;
+  char *lastline; /* copy of a last line that has no newline */
+};
+
+extern int map_textfile (struct textfile *f, const char *name);
+extern char *mapped_readline (struct textfile *f);
+extern void unmap_textfile (struct textfile *f);
+
 extern char *chomp (char *line);
 
 extern char *trim (char *line);
@@ -36,16 +53,31 @@ extern char *backtick(const char *progname, char *options);
 extern unsigned cksum (char *line);
 
 
-#define HASHSIZE 1003
+/* Perl style hashes: open addressing with linear probing over a slot
+ * table that doubles when it is three quarters full.  The items
+ * themselves are kept in insertion order, which is the order keys() and
+ * each() return them in.  A HashItem stays valid until the next new key
+ * is added.
+ */
+#define HASHSIZE 16 /* initial number of slots, a power of two */
 
 struct hash_item {
-  struct hash_item *next;
   char *name;
   void *value;
+  unsigned hashval;
 };
 
 typedef struct hash_item *HashItem;
-typedef HashItem *Hash;
+
+struct hash_table {
+  HashItem items;   /* in insertion order */
+  int nitems;
+  int itemsize;
+  int *slots;       /* indices into |items|, -1 for a free slot */
+  unsigned mask;    /* number of slots - 1 */
+};
+
+typedef struct hash_table *Hash;
 
 extern Hash make_hash (void) ;
 
@@ -61,6 +93,11 @@ extern HashItem set_value (Hash hashtab, char *name, char *defn);
 
 extern int keys (Hash hashtab,char * **thekeys);
 
+/* while (($name,$value) = each %hash), without allocating: start with
+ * |*k| = 0, the result is |NULL| after the last item.
+ */
+extern HashItem each (Hash hashtab, int *k);
+
 
 extern unsigned file_size (char *filename);
 extern int file_exists (char *filename);
@@ -24,11 +24,17 @@
 
 #include <time.h>
 #include <signal.h>
+#ifndef WIN32
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 #include "perlemu.h"
 #include "funclib.h"
 #include "texutil.h"
 #include "texexec.h"
+#include "md5.h"
 
 #ifdef WIN32
 #include <windows.h> /* for GetModuleFileName() */
@@ -83,6 +89,8 @@ int NoMPMode         = 0;
 int NoMPRun          = 0;
 int NoBanner         = 0;
 int AutoMPRun        = 0;
+int NoCache          = 0;
+int ParallelJobs     = 1;
 char *OutputFormat     = "standard";
 char *Pages            = "";
 char *PageScale        = "1000"; 
@@ -162,6 +170,7 @@ struct option long_options[] = {
    { "nomprun",        0, &NoMPRun, 1},
    { "nobanner",       0, &NoBanner, 1},
    { "automprun",      0, &AutoMPRun, 1},
+   { "nocache",        0, &NoCache, 1},
    { "once",           0, &RunOnce, 1},
    { "pdf",            0, &ProducePdfT, 1},
    { "pdm",            0, &ProducePdfM, 1},
@@ -218,6 +227,7 @@ struct option long_options[] = {
    { "print",        1,0,0}, //=> \$PrintFormat,
    { "suffix",       1,0,0}, //=> \$Suffix,
    { "runs",         1,0,0}, //=> \$NOfRuns,
+   { "jobs",         1,0,0},
    { "tex",          1,0,0}, //=> \$TeXProgram,
    { "input",        1,0,0}, //=> \$Input,
    { "arguments",    1,0,0}, //=> \$Arguments,
@@ -382,6 +392,10 @@ string opts[] = {
 "-----------",
 "automprun MetaPost at runtime when needed",
 "-----------",
+"nocache run TeX even when nothing changed since the last run",
+"-----------",
+"jobs typeset up to this many independent files at the same time",
+"-----------",
 "once run TeX only once (no TeXUtil either)",
 "-----------",
 "output specials to use",
@@ -556,6 +570,7 @@ int parse_options(int argc,  string * argv) {
    } else if (ARGUMENT_IS ("print"))        { PrintFormat = optarg;
    } else if (ARGUMENT_IS ("suffix"))       { Suffix = optarg;
    } else if (ARGUMENT_IS ("runs"))         { NOfRuns = atoi(optarg);
+   } else if (ARGUMENT_IS ("jobs"))         { ParallelJobs = atoi(optarg);
    } else if (ARGUMENT_IS ("tex"))          { TeXProgram = optarg;
    } else if (ARGUMENT_IS ("input"))        { Input = optarg;
    } else if (ARGUMENT_IS ("arguments"))    { Arguments = optarg;
@@ -690,7 +705,6 @@ struct locatedfile LocatedFile(char *PathToStartOn, char *FileToLocate , char *c
 	  }
 	}
   }
-  safe_free (testfile);
   return foundfile;
 }
 
@@ -819,13 +833,10 @@ void print_subopt (char *k, struct helpopt *opt ) {
   char *val = NULL;
   my_concat(&val,"--",k);
   p_write(3,val,opt->desc);
-  string *the_keys;
-  int numkeys = keys((Hash)opt->vals,&the_keys);
-  int i;
-  for (i=0;i<numkeys;i++) {
-    char *k = the_keys[i];
-    print_val(k, hash_value((Hash)opt->vals,k));
-  }
+  HashItem item;
+  int i = 0;
+  while ((item = each((Hash)opt->vals,&i)) != NULL)
+    print_val(item->name, (char *)item->value);
 }
 
 
@@ -837,22 +848,15 @@ void print_opt (char *k, struct helpopt *opt) {
   p_write(1,val,opt->desc);
   if (shorthelp < 0)
     return;
-  string *the_keys;
-  int numkeys = keys((Hash)opt->vals,&the_keys);
-  int i;
-  for (i=0;i<numkeys;i++) {
-    char *k = the_keys[i];
-    print_val(k, hash_value((Hash)opt->vals,k));
-    safe_free(the_keys[i]);
-  }
-  safe_free(the_keys);
+  HashItem item;
+  int i = 0;
+  while ((item = each((Hash)opt->vals,&i)) != NULL)
+    print_val(item->name, (char *)item->value);
   if (shorthelp > 0)
     return;
-  numkeys = keys((Hash)opt->subs,&the_keys);
-  for (i=0;i<numkeys;i++) {
-    char *k = the_keys[i];
-    print_subopt( k, do_get_value((Hash)opt->subs,k) );
-  }
+  i = 0;
+  while ((item = each((Hash)opt->subs,&i)) != NULL)
+    print_subopt(item->name, (struct helpopt *)item->value);
 }
 
 void show_help_info (int numhelp,string *help) {
@@ -920,8 +924,11 @@ char *QuotePath (char *oirg ){
   char *ret=NULL;
   char *e;
   while ((e = next_word(&path,","))) {
-    if ((e[0]!= '"') && (strchr(e,' ')!=NULL))
-      my_concat3(&e ,"\"", e, "\"");
+    if ((e[0]!= '"') && (strchr(e,' ')!=NULL)) {
+      char *quoted = NULL; /* |e| points into |path| */
+      my_concat3(&quoted ,"\"", e, "\"");
+      e = quoted;
+    }
     if (ret) {
       my_concat3(&ret,ret,",",e);
     } else {
@@ -1017,6 +1024,7 @@ void  CheckOutputFormat (void) {
   if (!STREQ(OutputFormat,"standard")) {
     char *F;
     char *zOutputFormat = safe_strdup(OutputFormat);
+    FullFormat = safe_strdup(FullFormat); /* it is extended below */
     while((F = words(&zOutputFormat,","))) {
       if (get_item(OutputFormats, lc (F ))) {
 	char *OF = hash_value(OutputFormats, lc (F));
@@ -1373,6 +1381,23 @@ void ScanContent (char *ConTeXtInput) {
   }
 }
 
+/* With --jobs=N, RunJobs typesets independent files in forked copies of
+ * texexec.  At most N run at the same time; each writes its terminal
+ * output to a file of its own, which is shown when that job and all jobs
+ * before it are done, so the output reads as if the jobs ran in turn.
+ * The job results live in shared memory, so that SystemTeX in a job can
+ * add its TeX run times to them for the summary at the end.
+ */
+
+struct jobresult {
+  int TeXRuns;
+  int TeXTime;
+  int RunTime;
+  int Status;
+};
+
+struct jobresult *CurrentJob = NULL;
+
 int SystemTeX (char *JobFile) {
   int StartTime = time(NULL);
   char *cmd=NULL;
@@ -1403,13 +1428,117 @@ int SystemTeX (char *JobFile) {
   my_concat3(&cmd,cmd,TeXFormatPath,Format);
   my_concat3(&cmd,cmd," ", JobFile);
   if (Verbose)        { fprintf(stdout,"\n%s\n\n",cmd); }
+  fflush(stdout); /* keep our messages ahead of those of TeX */
   MyProblems = system(cmd);
   int StopTime = time(NULL) - StartTime;
   fprintf(stdout, "\n           return code : %d",MyProblems);
   fprintf(stdout, "\n              run time : %d seconds\n",StopTime);
+  if (CurrentJob) {
+    CurrentJob->TeXRuns++;
+    CurrentJob->TeXTime += StopTime;
+  }
   return MyProblems;
 }
 
+void ShowJobOutput (FILE *Output) {
+  char buf[BUFSIZE];
+  size_t n;
+  if (Output == NULL)
+    return;
+  rewind(Output);
+  while ((n = fread(buf,1,BUFSIZE,Output)) > 0)
+    fwrite(buf,1,n,stdout);
+  fclose(Output);
+  fflush(stdout);
+}
+
+void RunJobs (int NOfJobs, string *Jobs, void (*RunJob)(char *)) {
+  int k;
+#ifndef WIN32
+  struct jobresult *Results;
+  FILE **Outputs;
+  pid_t *Pids;
+  time_t *Started;
+  int Running = 0;
+  int Next = 0;
+  int Shown = 0;
+  int Failed = 0;
+  int zero;
+  Results = MAP_FAILED;
+  if (NOfJobs > 0 && (zero = open("/dev/zero",O_RDWR)) >= 0) {
+    Results = mmap(NULL,sizeof(struct jobresult)*NOfJobs,PROT_READ|PROT_WRITE,
+		   MAP_SHARED,zero,0);
+    close(zero);
+  }
+  if (ParallelJobs > 1 && NOfJobs > 1 && Results != MAP_FAILED) {
+    memset(Results,0,sizeof(struct jobresult)*NOfJobs);
+    Outputs = safe_malloc(sizeof(FILE *)*NOfJobs);
+    Pids = safe_malloc(sizeof(pid_t)*NOfJobs);
+    Started = safe_malloc(sizeof(time_t)*NOfJobs);
+    fprintf(stdout, "            batch jobs : %d, %d at a time\n",NOfJobs,ParallelJobs);
+    while (Shown < NOfJobs) {
+      while (Running < ParallelJobs && Next < NOfJobs) {
+	k = Next++;
+	Outputs[k] = tmpfile();
+	Started[k] = time(NULL);
+	fflush(stdout);
+	fflush(stderr);
+	Pids[k] = (Outputs[k] ? fork() : -1);
+	if (Pids[k] == 0) {
+	  dup2(fileno(Outputs[k]),1);
+	  dup2(fileno(Outputs[k]),2);
+	  CurrentJob = &Results[k];
+	  Problems = 0;
+	  RunJob(Jobs[k]);
+	  fflush(stdout);
+	  fflush(stderr);
+	  _exit(Problems ? 1 : 0);
+	} else if (Pids[k] < 0) {
+	  fprintf(stderr, "texexec: cannot start a job for %s\n",Jobs[k]);
+	  Results[k].Status = 1;
+	  Pids[k] = 0;
+	} else {
+	  Running++;
+	}
+      }
+      if (Running) {
+	int status;
+	pid_t pid = wait(&status);
+	for (k=0; k<Next; k++) {
+	  if (pid > 0 && Pids[k] == pid) {
+	    Pids[k] = 0;
+	    Running--;
+	    Results[k].RunTime = time(NULL) - Started[k];
+	    Results[k].Status = !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	  }
+	}
+      }
+      while (Shown < Next && Pids[Shown] == 0)
+	ShowJobOutput(Outputs[Shown++]);
+    }
+    fprintf(stdout, "\n");
+    for (k=0; k<NOfJobs; k++) {
+      fprintf(stdout, "%22s : %d TeX runs, %d seconds TeX, %d seconds total%s\n",
+	      Jobs[k],Results[k].TeXRuns,Results[k].TeXTime,Results[k].RunTime,
+	      (Results[k].Status ? ", failed" : ""));
+      if (Results[k].Status)
+	Failed++;
+    }
+    if (Failed)
+      Problems = 1;
+    munmap(Results,sizeof(struct jobresult)*NOfJobs);
+    safe_free(Outputs);
+    safe_free(Pids);
+    safe_free(Started);
+    return;
+  }
+  if (Results != MAP_FAILED)
+    munmap(Results,sizeof(struct jobresult)*NOfJobs);
+#endif
+  for (k=0; k<NOfJobs; k++)
+    RunJob(Jobs[k]);
+}
+
 
 void F_CopyFile (char *From, char *To) { 
   FILE* INP;
@@ -1536,7 +1665,15 @@ int RunTeXutil (char *JobName){
   unlink (tup);
   rename (tuo,tup);
   fprintf(stdout, "  sorting and checking : running texutil\n");
-  texutil my_texutil = texutil_new();
+  /* one texutil for all passes, so that its register key cache
+   * survives from one pass to the next */
+  static texutil my_texutil = NULL;
+  if (my_texutil == NULL) {
+    my_texutil = texutil_new();
+    my_texutil->KeyCache_field = make_hash();
+  } else {
+    texutil_reset(my_texutil);
+  }
   my_texutil->TcXPath_field = TcXPath;
   my_texutil->ProcessReferences_field = 1;
   my_texutil->ProcessIJ_field = 1;
@@ -1625,37 +1762,294 @@ int RunTeXMP (char *JobName, char *MPfile) {
   return MPrundone;
 }
 
-/* perlversion  is broken: it does only each second file. */
-unsigned CheckChanges (char *JobName) { 
-  int checksum  = 0;
-  char *MPJobName = F_MPJobName( JobName, "mpgraph" );
-  FILE *MP;
-  safe_fopen(MP,MPJobName,"r");
-  if (MP) {
-    char *line = safe_malloc(sizeof(char *)*BUFSIZE);
-    while (readline(MP,&line)) {
+/* Convergence.
+ *
+ * A multi-pass run has converged when a TeX run leaves every auxiliary
+ * file it reads exactly as it found it: the utility files (.tui and .tuo)
+ * and the MetaPost files (mpgraph and mprun). Each of them is summarized
+ * by its MD5 digest before and after a pass, and another pass is only
+ * made when one of the digests has changed; the files that changed are
+ * reported. Lines with 'random' in the MetaPost files are skipped, as the
+ * perl version does.
+ *
+ * After a converged run the digests of the source, of every file listed
+ * in the log, of the auxiliary files and of the result are kept in
+ * JobName.tcv, together with a digest of the options. When all of these
+ * are still the same the next time, no TeX run is needed at all.
+ */
+
+#define CacheSuffix ".tcv"
+#define DigestSize 16
+
+struct filedigest {
+  char *name;
+  int present;
+  md5_byte_t digest[DigestSize];
+};
+
+struct digestset {
+  int number;
+  int size;
+  struct filedigest *files;
+};
+
+
+int IsMPFile (char *Name) {
+  size_t len = strlen(Name);
+  return (len > 3 && STREQ(Name+len-3,".mp"));
+}
+
+int FileDigest (char *Name, int SkipRandom, md5_byte_t *digest) {
+  FILE *F;
+  md5_state_t state;
+  safe_fopen(F,Name,"rb");
+  if (!F)
+    return 0;
+  md5_init(&state);
+  if (SkipRandom) {
+    char *line = safe_malloc(BUFSIZE);
+    while (fgets(line,BUFSIZE,F)) {
       if (strcasestr(line,"random")==NULL) {
-	checksum += (cksum(line) % 65535);
+	md5_append(&state,(md5_byte_t *)line,strlen(line));
       }
     }
-    safe_fclose(MP);
     safe_free(line);
+  } else {
+    char buf[BUFSIZE];
+    size_t n;
+    while ((n = fread(buf,1,BUFSIZE,F)) > 0) {
+      md5_append(&state,(md5_byte_t *)buf,n);
+    }
   }
-  MPJobName = F_MPJobName( JobName, "mprun" );
-  safe_fopen(MP,MPJobName,"r");
-  if (MP) {
-    char *line = safe_malloc(sizeof(char *)*BUFSIZE);
-    while (readline(MP,&line)) {
-      if (strcasestr(line,"random")==NULL) {
-	checksum += (cksum(line) % 65535);
+  safe_fclose(F);
+  md5_finish(&state,digest);
+  return 1;
+}
+
+void AddDigest (struct digestset *set, char *Name) {
+  int k;
+  for (k=0;k<set->number;k++) {
+    if (STREQ(set->files[k].name,Name))
+      return;
+  }
+  if (set->number == set->size) {
+    set->size = (set->size ? 2*set->size : 16);
+    set->files = safe_realloc(set->files,set->size*sizeof(struct filedigest));
+  }
+  struct filedigest *f = &set->files[set->number++];
+  f->name = safe_strdup(Name);
+  f->present = FileDigest(Name,IsMPFile(Name),f->digest);
+}
+
+void FreeDigests (struct digestset *set) {
+  int k;
+  for (k=0;k<set->number;k++) {
+    safe_free(set->files[k].name);
+  }
+  safe_free(set->files);
+  set->files = NULL;
+  set->number = set->size = 0;
+}
+
+/* the files a pass reads and writes, present or not */
+void AuxDigests (char *JobName, struct digestset *set) {
+  char *file = NULL;
+  my_concat(&file,JobName,".tuo");
+  AddDigest(set,file);
+  my_concat(&file,JobName,".tui");
+  AddDigest(set,file);
+  my_concat(&file,JobName,"-mpgraph.mp");
+  AddDigest(set,file);
+  AddDigest(set,"mpgraph.mp");
+  my_concat(&file,JobName,"-mprun.mp");
+  AddDigest(set,file);
+  AddDigest(set,"mprun.mp");
+  safe_free(file);
+}
+
+/* returns the number of files that differ, and reports them */
+int ReportChanges (struct digestset *before, struct digestset *after) {
+  int j, k, changed = 0;
+  for (k=0;k<after->number;k++) {
+    struct filedigest *a = &after->files[k];
+    struct filedigest *b = NULL;
+    for (j=0;j<before->number;j++) {
+      if (STREQ(before->files[j].name,a->name)) {
+	b = &before->files[j];
+	break;
       }
     }
-    safe_fclose(MP);
-    safe_free(line);
+    if (b == NULL || b->present != a->present ||
+	(a->present && memcmp(a->digest,b->digest,DigestSize)!=0)) {
+      char *how = "changed";
+      if (b == NULL || !b->present) { how = "created"; }
+      else if (!a->present)         { how = "removed"; }
+      if (!changed) {
+	fprintf(stdout, "\n    another run needed :");
+      }
+      fprintf(stdout, " %s %s",a->name,how);
+      changed++;
+    }
+  }
+  if (changed) { fprintf(stdout, "\n"); }
+  return changed;
+}
+
+/* everything that determines the result, apart from the files */
+void OptionDigest (char *JobFile, md5_byte_t *digest) {
+  md5_state_t state;
+  char *parts[] = { JobFile, TeXExecutable, Format, FullFormat, OutputFormat,
+		    Mode, Arguments, Modules, Environments, Filters, Pages,
+		    PaperFormat, PrintFormat, TeXTranslation, PassOn, Result,
+		    Suffix, MainLanguage, MainBodyFont, ConTeXtInterface, NULL };
+  int flags[] = { FastMode, FinalMode, Random, UseColor, CenterPage,
+		  Arrange, NoArrange, NoMPMode, AutoMPRun, NOfRuns };
+  int k;
+  md5_init(&state);
+  for (k=0;parts[k]!=NULL;k++) {
+    md5_append(&state,(md5_byte_t *)parts[k],strlen(parts[k])+1);
   }
-  return checksum;
+  md5_append(&state,(md5_byte_t *)flags,sizeof(flags));
+  md5_finish(&state,digest);
 }
 
+char *DigestString (md5_byte_t *digest) {
+  static char hex[2*DigestSize+1];
+  int k;
+  for (k=0;k<DigestSize;k++) {
+    sprintf(hex+2*k,"%02x",digest[k]);
+  }
+  return hex;
+}
+
+/* Adds the files TeX reports opening in its log. TeX breaks long lines
+ * at 79 characters, so those are joined first; names that are not files
+ * (page numbers and the like) are dropped by the file test.
+ */
+void LogDigests (char *JobName, struct digestset *set) {
+  FILE *LOG;
+  char *logfile = NULL;
+  my_concat(&logfile,JobName,".log");
+  safe_fopen(LOG,logfile,"r");
+  safe_free(logfile);
+  if (!LOG)
+    return;
+  char *line = safe_malloc(BUFSIZE);
+  size_t size = BUFSIZE, used = 0;
+  char *text = safe_malloc(size);
+  int joined = 0;
+  text[0] = 0;
+  while (fgets(line,BUFSIZE,LOG)) {
+    size_t len = strlen(line);
+    if (len && line[len-1]=='\n') {
+      line[--len] = 0;
+    }
+    if (used+len+2 > size) {
+      while (used+len+2 > size)
+	size *= 2;
+      text = safe_realloc(text,size);
+    }
+    if (!joined) { text[used++] = '\n'; }
+    memcpy(text+used,line,len+1);
+    used += len;
+    joined = (len == 79);
+  }
+  safe_fclose(LOG);
+  safe_free(line);
+  char *p = text;
+  while ((p = strpbrk(p,"({<"))) {
+    char *q = ++p;
+    while (*q && !isspace((unsigned char)*q) && !strchr(")}>[",*q)) { q++; }
+    if (q > p) {
+      char *name = strndup(p,q-p);
+      if (file_exists(name) && !dir_exists(name)) { AddDigest(set,name); }
+      safe_free(name);
+    }
+    p = q;
+  }
+  safe_free(text);
+}
+
+void ResultDigests (char *JobName, struct digestset *set) {
+  char *file = NULL;
+  char *base = (strlen(Result) ? Result : JobName);
+  my_concat(&file,base,".pdf");
+  if (file_exists(file)) { AddDigest(set,file); }
+  my_concat(&file,base,".dvi");
+  if (file_exists(file)) { AddDigest(set,file); }
+  safe_free(file);
+}
+
+void WriteCache (char *JobName, char *JobFile, struct digestset *set) {
+  FILE *CACHE;
+  md5_byte_t digest[DigestSize];
+  char *cachefile = NULL;
+  int k;
+  my_concat(&cachefile,JobName,CacheSuffix);
+  safe_fopen(CACHE,cachefile,"w");
+  safe_free(cachefile);
+  if (!CACHE)
+    return;
+  OptionDigest(JobFile,digest);
+  fprintf(CACHE,"%% texexec convergence cache\n");
+  fprintf(CACHE,"options %s\n",DigestString(digest));
+  for (k=0;k<set->number;k++) {
+    if (set->files[k].present) {
+      fprintf(CACHE,"file %s %s\n",DigestString(set->files[k].digest),set->files[k].name);
+    } else {
+      fprintf(CACHE,"nofile %s\n",set->files[k].name);
+    }
+  }
+  safe_fclose(CACHE);
+}
+
+void UpdateCache (char *JobName, char *SourceFile, int DummyFile) {
+  struct digestset cache = { 0, 0, NULL };
+  if (!DummyFile) { AddDigest(&cache,SourceFile); }
+  LogDigests(JobName,&cache);
+  AuxDigests(JobName,&cache);
+  ResultDigests(JobName,&cache);
+  WriteCache(JobName,SourceFile,&cache);
+  FreeDigests(&cache);
+}
+
+/* returns 1 when the cache says a TeX run would change nothing */
+int CacheIsCurrent (char *JobName, char *JobFile) {
+  FILE *CACHE;
+  md5_byte_t digest[DigestSize];
+  char *cachefile = NULL;
+  int current = 1, files = 0;
+  my_concat(&cachefile,JobName,CacheSuffix);
+  safe_fopen(CACHE,cachefile,"r");
+  safe_free(cachefile);
+  if (!CACHE)
+    return 0;
+  OptionDigest(JobFile,digest);
+  char *line = safe_malloc(BUFSIZE);
+  while (current && readline(CACHE,&line)) {
+    line = chomp(line);
+    if (strncmp(line,"options ",8)==0) {
+      current = STREQ(line+8,DigestString(digest));
+    } else if (strncmp(line,"file ",5)==0 && strlen(line)>6+2*DigestSize) {
+      char *name = line+6+2*DigestSize;
+      line[5+2*DigestSize] = 0;
+      current = (FileDigest(name,IsMPFile(name),digest)
+		 && STREQ(line+5,DigestString(digest)));
+      if (!current) {
+	fprintf(stdout, "     convergence cache : %s changed\n",name);
+      }
+      files++;
+    } else if (strncmp(line,"nofile ",7)==0) {
+      current = !file_exists(line+7);
+      if (!current) {
+	fprintf(stdout, "     convergence cache : %s created\n",line+7);
+      }
+    }
+  }
+  safe_fclose(CACHE);
+  safe_free(line);
+  return (current && files);
+}
 
 int isXMLfile (char *Name) {
   char *qtest = strrchr(Name,'.');
@@ -1782,10 +2176,17 @@ void RunConTeXtFile (char *JobName, char *JobSuffix ) {
     if (strlen(Modules))      { fprintf(stdout, "               modules : %s\n",Modules); }
     if (strlen(Environments)) { fprintf(stdout, "          environments : %s\n",Environments); }
     if (strlen(Suffix))       { Result = NULL; my_concat(&Result,JobName,Suffix); }
-    PushResult(JobName);
+    char *SourceFile = NULL;
+    my_concat3(&SourceFile,JobName,".",OriSuffix);
+    int UseCache = ( (!NoCache) && (!PdfArrange) && (!PdfSelect) && (!RunOnce) &&
+		     (!Optimize) && (!strlen(Result)) && ( NOfRuns > 1 ) );
+    int UpToDate = ( UseCache && CacheIsCurrent(JobName,SourceFile) );
+    if (!UpToDate) { PushResult(JobName); }
     Problems = 0;
     int TeXRuns = 0;
-    if ( (PdfArrange) || (PdfSelect) || (RunOnce) ) {
+    if (UpToDate) {
+      fprintf(stdout, "     convergence cache : nothing changed, no TeX run needed\n");
+    } else if ( (PdfArrange) || (PdfSelect) || (RunOnce) ) {
       MakeOptionFile( 1, 1, JobName, OriSuffix, 3 );
       fprintf(stdout, "\n");
       char *JobFile = NULL;
@@ -1800,6 +2201,8 @@ void RunConTeXtFile (char *JobName, char *JobSuffix ) {
       unlink (topfile);   
       PopResult(JobName);
     } else {
+      struct digestset before = { 0, 0, NULL };
+      struct digestset after  = { 0, 0, NULL };
       while ( (!StopRunning) && ( TeXRuns < NOfRuns ) && ( !Problems ) ) {
 	++TeXRuns;
 	if (TeXRuns == 1 ) {
@@ -1808,24 +2211,24 @@ void RunConTeXtFile (char *JobName, char *JobSuffix ) {
 	  MakeOptionFile( 0, 0, JobName, OriSuffix, 2 );
 	}
 	fprintf(stdout, "               TeX run : %d\n\n",TeXRuns);
-	unsigned mpchecksumbefore = 0;
-	unsigned mpchecksumafter = 0;
-	if (AutoMPRun) { mpchecksumbefore = CheckChanges(JobName); }
+	FreeDigests(&before);
+	AuxDigests(JobName,&before);
 	char *JobFile = NULL;
 	my_concat3(&JobFile,JobName,".",JobSuffix);
 	Problems = RunTeX( JobFile );
-	if (AutoMPRun) { mpchecksumafter = CheckChanges(JobName); }
 	if ( ( !Problems ) && ( NOfRuns > 1 ) ) {
 	  if ( !NoMPMode ) {
 	    MPrundone = RunTeXMP( JobName, "mpgraph" );
 	    MPrundone = RunTeXMP( JobName, "mprun" );
 	  }
-	  StopRunning = RunTeXutil(JobName);
-	  if (AutoMPRun) {
-	    StopRunning =(StopRunning && ( mpchecksumafter == mpchecksumbefore ));
-	  }
+	  RunTeXutil(JobName);
+	  FreeDigests(&after);
+	  AuxDigests(JobName,&after);
+	  StopRunning = (ReportChanges(&before,&after) == 0);
 	}
       }
+      FreeDigests(&before);
+      FreeDigests(&after);
       if ( ( NOfRuns == 1 ) && ForceTeXutil ) {
 	Ok = RunTeXutil(JobName);
       }
@@ -1851,6 +2254,9 @@ void RunConTeXtFile (char *JobName, char *JobSuffix ) {
     if (DummyFile) {
       unlink (jobfile);
     }
+    if ( UseCache && StopRunning && ( !Problems ) ) {
+      UpdateCache(JobName,SourceFile,DummyFile);
+    }
     if ((dosish) && (!Problems) && (PdfOpen)) {
       char *cmdline = NULL;
       if (strlen(Result)) {
@@ -1880,6 +2286,12 @@ void RunSomeTeXFile (char *JobName, char*JobSuffix){
 
 void DoRunModule ( char *FileName, char *FileSuffix ) {
   char *ModuleFile  = "texexec";
+  if (CurrentJob) { /* parallel jobs share the directory */
+    char pid[32];
+    snprintf(pid,32,"%d",(int)getpid());
+    ModuleFile = NULL;
+    my_concat3(&ModuleFile,"texexec","-",pid);
+  }
   char *file = NULL;
   my_concat3(&file,FileName,".",FileSuffix);
   texutil my_texutil = texutil_new();
@@ -1891,12 +2303,14 @@ void DoRunModule ( char *FileName, char *FileSuffix ) {
   fprintf(stdout, "                module : %s\n\n",FileName);
   FILE *MOD;
   char *texfile = NULL;
-  my_concat(&texfile,FileName,".tex");
+  my_concat(&texfile,ModuleFile,".tex");
   safe_fopen( MOD, texfile,"w");
+  if (!MOD)
+    return;
   char *tedfile = NULL;
   my_concat(&tedfile,FileName,".ted");
   FILE *TED;
-  safe_fopen( TED, texfile,"r");
+  safe_fopen( TED, tedfile,"r");
   if (TED) {
     char *firstline = malloc(sizeof(char *)*BUFSIZE);
     readline(TED,&firstline);
@@ -1925,6 +2339,19 @@ void DoRunModule ( char *FileName, char *FileSuffix ) {
   }
   my_concat3(&ms,ModuleFile,".","tex");
   unlink(ms);
+  if (CurrentJob) { /* nobody will reuse these */
+    char *Helpers[4] = {"tmp", "top", "tup", "tcv" };
+    for (k=0; k<4; k++) {
+      my_concat3(&ms,ModuleFile,".",Helpers[k]);
+      unlink(ms);
+    }
+  }
+}
+
+void RunModuleFile (char *FileName) {
+  char *File = safe_strdup(FileName);
+  char *Name = next_word(&File,".");
+  DoRunModule( Name, File );
 }
 
 void RunModule (int Filenamecount,string *Filenames){
@@ -1942,19 +2369,21 @@ void RunModule (int Filenamecount,string *Filenames){
       Filenames[k] = file;
     }
   }
+  string *Modules = safe_malloc(sizeof(char *)*(Filenamecount+1));
+  int NOfModules = 0;
   for (k=0; k<Filenamecount;k++) {
-    char *FileName = Filenames[k];
-    if(!file_exists(FileName))
+    char *Suffix = strchr(Filenames[k],'.');
+    if(!file_exists(Filenames[k]) || Suffix == NULL)
       continue;
-    char *Name = next_word(&FileName,".");
-    char *Suffix = FileName;
     if (!(strcasestr(Suffix,"tex")||
 	  strcasestr(Suffix,"mp")||
 	  strcasestr(Suffix,"pl")||
 	  strcasestr(Suffix,"pm")))
       continue;
-    DoRunModule( Name, Suffix );
+    Modules[NOfModules++] = Filenames[k];
   }
+  RunJobs(NOfModules,Modules,RunModuleFile);
+  safe_free(Modules);
 }
 
 void RunFigures (int Filecount, string*Files){
@@ -2391,7 +2820,7 @@ void RunMpFormat (char *MpFormat) {
   if (strlen(MpFormatPath)) { 
     chdir (MpFormatPath);
   }
-  char *exe = MpExecutable;
+  char *exe = safe_strdup(MpExecutable);
   if ((own_path[0]!= '"') && (strchr(MpExecutable,' ')!=NULL))
     my_concat3(&exe,"\"",exe,"\"");
   char *cmd = NULL;
@@ -2475,6 +2904,29 @@ void RunFormats (int ARGC, string *ARGV, char *fmtutil){
 
 
 
+void RunJobFile (char *FileName) {
+  char *JobSuffix = "tex";
+  char *JobName = safe_strdup(FileName);
+  if (strrchr(JobName,'.')!=NULL && 
+      strrchr(JobName,'.')<(JobName+strlen(JobName))) {
+    JobSuffix = strrchr(JobName,'.');
+    *JobSuffix = 0;
+    JobSuffix++;
+  }
+  if ((!(strlen(Format)) || (strcasestr(Format,"cont")==Format))) {
+    RunConTeXtFile( JobName, JobSuffix );
+  } else {
+    RunSomeTeXFile( JobName, JobSuffix );
+  }
+  char *file = NULL;
+  my_concat(&file,JobName,".log");
+  if (file_exists(file) && file_size(file)==0)
+    unlink(file);
+  my_concat(&file,JobName,".tui");
+  if (file_exists(file) && file_size(file)==0)
+    unlink(file);
+}
+
 void RunFiles (int ARGC,string *ARGV) {
   char *pdffile = NULL;
   if (PdfArrange) {
@@ -2484,9 +2936,10 @@ void RunFiles (int ARGC,string *ARGV) {
     for (i=0;i<ARGC;i++) {
       char *JobName = ARGV[i];
       if (!(strcasestr(JobName,".pdf")==(JobName+strlen(JobName)-4))) {
+	pdffile = NULL; /* the previous one is in |arrangedfiles| */
 	my_concat(&pdffile,JobName,".pdf");
 	if (file_exists(pdffile)) { JobName= pdffile; }
-	else { my_concat(&JobName,JobName,".PDF"); }
+	else { JobName = NULL; my_concat(&JobName,ARGV[i],".PDF"); }
       }
       arrangedfiles[arrangedfilessize++] = JobName;
     }
@@ -2499,7 +2952,7 @@ void RunFiles (int ARGC,string *ARGV) {
       if (!(strcasestr(JobName,".pdf")==(JobName+strlen(JobName)-4))) {
 	my_concat(&pdffile,JobName,".pdf");
 	if (file_exists(pdffile)) { JobName= pdffile; }
-	else { my_concat(&JobName,JobName,".PDF"); }
+	else { JobName = NULL; my_concat(&JobName,ARGV[0],".PDF"); }
       }
       if      (PdfSelect) { RunSelect(JobName); }
       else if (PdfCopy)   { RunCopy(JobName); }
@@ -2510,36 +2963,14 @@ void RunFiles (int ARGC,string *ARGV) {
   } else if (TypesetModule) {
     RunModule(ARGC,ARGV);
   } else {
-    char *JobSuffix = "tex";
-    int i=0;
-    for (i=0;i<ARGC;i++) {
-      char *JobName = safe_strdup(ARGV[i]);
-      if (strrchr(JobName,'.')!=NULL && 
-	  strrchr(JobName,'.')<(JobName+strlen(JobName))) {
-	JobSuffix = strrchr(JobName,'.');
-	*JobSuffix = 0;
-	JobSuffix++;
-      }
-      if ((!(strlen(Format)) || (strcasestr(Format,"cont")==Format))) {
-	RunConTeXtFile( JobName, JobSuffix );
-      } else {
-	RunSomeTeXFile( JobName, JobSuffix );
-      }
-      char *file = NULL;
-      my_concat(&file,JobName,".log");
-      if (file_exists(file) && file_size(file)==0)
-	unlink(file);
-      my_concat(&file,JobName,".tui");
-      if (file_exists(file) && file_size(file)==0)
-	unlink(file);
-    }
+    RunJobs(ARGC,ARGV,RunJobFile);
   }
 }
 
 
 int checkMPgraphics (char *MpName) {
   unsigned mpochecksum = 0;
-  char *cmdline = MpName;
+  char *cmdline = safe_strdup(MpName);
   if (strlen(MakeMpy)) { 
     my_concat3(&cmdline,cmdline," --",MakeMpy);
   }
@@ -2715,8 +3146,8 @@ void doRunMP (char *MpName, int MergeBE, Hash mpbetex){
 		    zeroseen = 1;
 		  my_concat3(&addf,"beginfig(",Itoa(val),");\n");
 		  my_concat3(&addf,addf,hash_value(mpbetex,Itoa(val)),"\n");
-		  safe_free(addf);
 		  my_concat(&Newdata,Newdata,addf);
+		  safe_free(addf);
 		} else {
 		  seen = strndup(MPdata,(next-MPdata));
 		  my_concat(&Newdata,Newdata,seen);
@@ -2944,6 +3375,8 @@ void load_set_file (char *file, int trace) {
 	    val++;
 	    val = chop (val);
 	    val = getenv(val);
+	    if (val == NULL)
+	      val = "";
 	  }
 	  if (!get_item(old,var)) {
 	    if (getenv(var)!=NULL) { 
@@ -2952,7 +3385,7 @@ void load_set_file (char *file, int trace) {
 	    set_value(old,var,safe_strdup(""));
 	    }
 	  }
-	  set_value(old,var,safe_strdup(val));
+	  set_value(new,var,safe_strdup(val));
 	  setenv(var,val,1);
 	}
       }
@@ -3148,6 +3581,7 @@ int texexec_main(int ac,  string *av) {
   }
   if (!strlen(IniPath)) {
     if (getenv("TEXEXEC_INI_FILE") ) {
+      IniPath = NULL;
       my_concat(&IniPath,checked_path(getenv("TEXEXEC_INI_FILE")),"texexec.ini");
       if(!file_exists(IniPath)) { IniPath = strdup(""); }
     }
@@ -3160,6 +3594,7 @@ int texexec_main(int ac,  string *av) {
     }
   }
   if (!strlen(IniPath)) {
+    IniPath = NULL;
     my_concat(&IniPath,own_path,"texexec.ini");
     if(!file_exists(IniPath)) { IniPath = strdup(""); }
     if (Verbose) {
@@ -3264,6 +3699,7 @@ int texexec_main(int ac,  string *av) {
   if (!strlen(TeXScriptsPath)) { TeXScriptsPath = own_path; }
   if (!strlen(ConTeXtPath)) { ConTeXtPath = TeXScriptsPath; }
   if (getenv("HOME")) {
+    SetupPath = safe_strdup(SetupPath); /* it may be an ini file value */
     if (SetupPath) { my_concat(&SetupPath,SetupPath,","); }
     my_concat(&SetupPath,SetupPath,getenv("HOME"));
   }
@@ -74,6 +74,8 @@
 #define SynonymEntry		   TeXUtil->SynonymEntry_field
 #define SynonymEntry_size	   TeXUtil->SynonymEntry_size_field
 #define SynonymEntry_add	   TeXUtil->SynonymEntry_add_field
+#define EntryArena		   TeXUtil->EntryArena_field
+#define KeyCache		   TeXUtil->KeyCache_field
 #define Files			   TeXUtil->Files_field
 #define File_opens		   TeXUtil->File_opens_field
 #define Files_size		   TeXUtil->Files_size_field
@@ -107,8 +109,8 @@ static const char *Program = "TeXUtil 8.2 - ConTeXt / PRAGMA ADE 1992-2004/C por
 #endif
 
 #define EXTEND_ARRAY(a,b)				     \
-    if (a##_size < b) {                                      \
-      a = safe_realloc(a,sizeof(char*)*(a##_size+a##_add));  \
+    if (a##_size <= b) {                                     \
+      a = safe_realloc(a,sizeof(*a)*(a##_size+a##_add));     \
       a##_size = a##_size+a##_add;                           \
     }
 
@@ -127,7 +129,7 @@ static const char *Program = "TeXUtil 8.2 - ConTeXt / PRAGMA ADE 1992-2004/C por
 #define ASCII_apos  'd'
 #define ASCII_tilde 'e'
 #define ASCII_comma 'f'
-#define ishex(a) ((a>='0'&&a<=9) || (a>='a'&&a<='f'))
+#define ishex(a) ((a>='0'&&a<='9') || (a>='a'&&a<='f'))
 #define DPtoCM  (2.54/72.0) 
 #define INtoCM  (2.54)
 
@@ -420,8 +422,9 @@ char *SetOutputFile (texutil TeXUtil,char *proposeda) {
   }
   if (strlen(ProcessOutputFile)) {
     my_concat(&FilSuf,".",OutFilSuf);
-    my_concat(&ProcessOutputFile,ProcessOutputFile,FilSuf);
-    char *Rubish = ProcessOutputFile;
+    char *Rubish = NULL;
+    my_concat(&Rubish,ProcessOutputFile,FilSuf);
+    ProcessOutputFile = Rubish;
     OutFilNam = next_word(&Rubish,".");
     if (strchr(Rubish,'.') != NULL) {
       OutFilSuf = next_word(&Rubish,".");
@@ -1068,13 +1071,14 @@ void RunExtraPrograms (texutil TeXUtil) {
     */
   }
   safe_free(ExtraPrograms);
+  ExtraPrograms = NULL;
 }
 
 /* char *SectionSeparator = ":" ; */
 
 
 #define ESCAPED_CHAR(a,b)                 \
-  NewKey = safe_malloc(strlen(a)*2);      \
+  NewKey = safe_malloc(strlen(a)*2+1);      \
   apointer = a;                           \
   rover= 0;                               \
   while (*a) {                            \
@@ -1096,7 +1100,7 @@ void RunExtraPrograms (texutil TeXUtil) {
 
 
 #define ESCAPED_IJ(a)                     \
-  NewKey = safe_malloc(strlen(a)*2);      \
+  NewKey = safe_malloc(strlen(a)*2+1);      \
   apointer = a;                           \
   rover= 0;                               \
   while (*a) {                            \
@@ -1120,6 +1124,7 @@ void RunExtraPrograms (texutil TeXUtil) {
       (strchr(Key,'}') != NULL)             \
       &&                                   \
       (strchr(Key,'{') < strchr(Key,'}'))) { \
+    char *Start = Key;                     \
     while (isspace(*Key))                  \
       Key++;                               \
     if (*Key == '{') {                     \
@@ -1128,12 +1133,15 @@ void RunExtraPrograms (texutil TeXUtil) {
     char *End = strrchr(Key,'}');           \
     *End = 0;                              \
     End++;                                 \
-    my_concat(&Key,Key,End);		   \
+    char *Stripped = NULL;                 \
+    my_concat(&Stripped,Key,End);	   \
+    safe_free(Start);                      \
+    Key = Stripped;                        \
   }
 
 /*    inputstring =~ s/\\([\^\"\`\'\~\,])/$1/g ;*/
 #define DROP_ACCENT_BACKSLASHES(a)             \
-  NewKey = safe_malloc(strlen(a)*2);           \
+  NewKey = safe_malloc(strlen(a)*2+1);           \
   apointer = a;                                \
   rover= 0;                                    \
   PrevChar=0;                                  \
@@ -1231,7 +1239,7 @@ void RunExtraPrograms (texutil TeXUtil) {
 
 
 char *SanitizedString (texutil TeXUtil,char *original) {
-  char *inputstring = original;
+  char *inputstring = safe_strdup(original); /* the steps below free their input */
   char *apointer; /* for the macros */
   char *copied;
   char *NewKey;
@@ -1254,11 +1262,13 @@ char *SanitizedString (texutil TeXUtil,char *original) {
   while (*inputstring) {
     if (*inputstring == '<') {
       inputstring++;
-      if (*inputstring == '*') {
+      if (*inputstring == '*' && strchr(inputstring,'>')) {
+	inputstring++;
 	NewKey[rover++] = '\\';
 	while(*inputstring!='>') {
 	  NewKey[rover++] = *inputstring++;
 	}
+	inputstring++;
 	NewKey[rover++] = ' ';
       } else {
 	NewKey[rover++] = '<';
@@ -1280,10 +1290,8 @@ char *SanitizedString (texutil TeXUtil,char *original) {
   while (*inputstring) {
     if (*inputstring == '<') {
       inputstring++;
-      if (*inputstring == '/' || isalpha(*inputstring)) {
-	while(*inputstring!='>') {
-	  NewKey[rover++] = *inputstring++;
-	}
+      if ((*inputstring == '/' || isalpha(*inputstring)) && strchr(inputstring,'>')) {
+	inputstring = strchr(inputstring,'>')+1;
       } else {
 	NewKey[rover++] = '<';
       }
@@ -1321,30 +1329,190 @@ char *SanitizedString (texutil TeXUtil,char *original) {
 
 char *HighConverted (char *inputstring) {
   /* $string =~ s/\^\^([a-f0-9][a-f0-9])/chr hex($1)/geo ;*/
-  char *Class;
-  char *result = NULL;
-  char val[2];
-  val[1] = 0;
-  unsigned int *hexchar=0;
-  while((Class = next_word(&inputstring, "^^"))!=NULL) {
-    my_concat(&result,result,Class);
-    if (ishex(inputstring[0]) && ishex(inputstring[1])) {
-      if(sscanf(inputstring,"%2x",hexchar)==1) {
-	val[0] = *hexchar;
-	my_concat (&result,result,val);
-      }
+  /* the result is never longer than the input */
+  char *result = safe_malloc(strlen(inputstring)+1);
+  char *r = result;
+  unsigned int hexchar;
+  while (*inputstring) {
+    if (inputstring[0]=='^' && inputstring[1]=='^' &&
+	ishex(inputstring[2]) && ishex(inputstring[3]) &&
+	sscanf(inputstring+2,"%2x",&hexchar)==1) {
+      if (hexchar)
+	*r++ = hexchar;
+      inputstring += 4;
     } else {
-      my_concat(&result,result,"^^");
+      *r++ = *inputstring++;
     }
   }
-  my_concat(&result,result,inputstring);
-  safe_free(val);
+  *r = 0;
   return result;
 }
 
 
-void HandleRegister (texutil TeXUtil, char *RestOfLine) {
+/* Register and synonym entries are sorted like the perl version sorts
+ * its joined lines: case insensitive over the whole line.  The line is
+ * case folded once into a key that is stored with the entry, and the keys
+ * are merge sorted bytewise.  The first eight bytes of each key are kept
+ * in the sort array, so most comparisons never touch the entries, and
+ * the sort is stable like the qsort of the C library.
+ */
+
+struct sortitem {
+  unsigned long long prefix;
+  const unsigned char *key;
+  int length;
+  int index;
+};
+
+static void MakeSortItem (struct sortitem *item, const unsigned char *key, int length, int index) {
+  int k;
+  item->prefix = 0;
+  for (k=0;k<8;k++)
+    item->prefix = (item->prefix << 8) | (k < length ? key[k] : 0);
+  item->key = key;
+  item->length = length;
+  item->index = index;
+}
+
+static int SortItemCompare (const struct sortitem *a, const struct sortitem *b) {
+  int m, c;
+  if (a->prefix != b->prefix)
+    return (a->prefix < b->prefix ? -1 : 1);
+  /* keys have no zero bytes, so equal prefixes mean equal first bytes */
+  m = (a->length < b->length ? a->length : b->length);
+  if (m > 8 && (c = memcmp(a->key+8,b->key+8,m-8)) != 0)
+    return c;
+  return a->length - b->length;
+}
+
+static void SortItems (struct sortitem *items, int n) {
+  struct sortitem *from = items, *to, *swap;
+  int width, lo, mid, hi, i, j, k;
+  if (n < 2)
+    return;
+  to = safe_malloc(sizeof(struct sortitem)*n);
+  for (width=1;width<n;width*=2) {
+    for (lo=0;lo<n;lo+=2*width) {
+      mid = (lo+width < n ? lo+width : n);
+      hi  = (lo+2*width < n ? lo+2*width : n);
+      i = lo; j = mid; k = lo;
+      while (i<mid && j<hi)
+	to[k++] = (SortItemCompare(&from[j],&from[i]) < 0 ? from[j++] : from[i++]);
+      while (i<mid)
+	to[k++] = from[i++];
+      while (j<hi)
+	to[k++] = from[j++];
+    }
+    swap = from; from = to; to = swap;
+  }
+  if (from != items) {
+    memcpy(items,from,sizeof(struct sortitem)*n);
+    to = from;
+  }
+  safe_free(to);
+}
+
+/* a case folded copy of |line| in the entry arena */
+static unsigned char *FoldedKey (texutil TeXUtil, const char *line, int length) {
+  unsigned char *key = arena_alloc(EntryArena,length+1);
+  int k;
+  for (k=0;k<length;k++)
+    key[k] = tolower((unsigned char)line[k]);
+  key[length] = 0;
+  return key;
+}
+
+
+/* The sort key and the entry text of a register entry, as rewritten by
+ * RegisterKey below.  This depends on nothing but the key, the entry,
+ * the options and the sort tables loaded by HandleKey (of which only
+ * |SortN| survives the `k' line), so when a texutil is used for several
+ * runs (texexec does that between TeX passes) the results are kept in
+ * |KeyCache|, filed under all of these, and only new entries are
+ * rewritten again.
+ */
+struct registerkey {
+  char *Key;
+  char *LCKey;
+  char *Entry;
+};
+
+static struct registerkey *RegisterKey (texutil TeXUtil, char *Key, char *Entry) {
   char *SortMethod = "";
+  char *Converted = NULL;
+  if (strlen(Key) == 0)
+    Key = Converted = SanitizedString(TeXUtil,Entry);
+  if (strlen(SortMethod))
+    ProcessHigh = 0;
+  if (ProcessHigh) {
+    Key = HighConverted(Key);
+    safe_free(Converted);
+    Converted = Key;
+  }
+  int KeyTag;
+  KeyTag = Key[0];
+  char *NewKey;
+  char *apointer;
+  int rover;
+  /* the escapes below free their input, so they get copies */
+  if (Converted == NULL)
+    Key = safe_strdup(Key);
+  Entry = safe_strdup(Entry);
+  if (KeyTag == '&') {
+    while (strchr(Key,'&') == 0)
+      Key++;
+    ESCAPED_CHAR(Key,'&');
+  } else if (KeyTag == '+') {
+    while (strchr(Key,'+') == 0)
+      Key++;
+    ESCAPED_CHAR(Key,'+');
+  } else {
+    ESCAPED_CHAR(Key,'&');
+    ESCAPED_CHAR(Key,'+');
+  }
+  my_concat (&Key,Key," "); /* so, "Word" comes for "Word Another Word" */
+  int EntryTag;
+  EntryTag = Entry[0] ;
+  if (EntryTag == '&') {
+    while (strchr(Entry,'&') == 0)
+      Entry++;
+    ESCAPED_CHAR(Entry,'&');
+  } else if (EntryTag == '+') {
+    while (strchr(Entry,'+') == 0)
+      Entry++;
+    ESCAPED_CHAR(Entry,'+');
+  } else if (KeyTag == '&') {
+    ESCAPED_CHAR(Entry,'&');
+  } else if (KeyTag == '+') {
+    ESCAPED_CHAR(Entry,'+');
+  } else {
+    ESCAPED_CHAR(Entry,'&');
+    ESCAPED_CHAR(Entry,'+');
+  }
+  if (!isalpha(Key[0]))
+    my_concat(&Key," ",Key);
+  STRIP_PRE_SPACE_AND_BRACES(Key);
+  if (*Entry == '{')
+    STRIP_PRE_SPACE_AND_BRACES(Entry);
+  if (ProcessIJ) {
+    ESCAPED_IJ(Key);
+  }
+  char *LCKey = lc(Key);
+  size_t kl = strlen(Key)+1, el = strlen(Entry)+1;
+  struct registerkey *Keys = safe_malloc(sizeof(struct registerkey)+2*kl+el);
+  Keys->Key   = (char *)(Keys+1);
+  Keys->LCKey = Keys->Key+kl;
+  Keys->Entry = Keys->LCKey+kl;
+  memcpy(Keys->Key,Key,kl);
+  memcpy(Keys->LCKey,LCKey,kl);
+  memcpy(Keys->Entry,Entry,el);
+  safe_free(LCKey);
+  safe_free(Key);
+  safe_free(Entry);
+  return Keys;
+}
+
+void HandleRegister (texutil TeXUtil, char *RestOfLine) {
   int SecondTag;
   if (strlen(RestOfLine) > 2 && RestOfLine[1] == ' ') {
     SecondTag = RestOfLine[0];
@@ -1394,60 +1562,20 @@ void HandleRegister (texutil TeXUtil, char *RestOfLine) {
   char *TextHow = "";
   if (strstr(Entry,RegSep) != NULL)
     TextHow = next_word(&Entry,RegSep);
-  if (strlen(Key) == 0)
-    Key = SanitizedString(TeXUtil,Entry);
-  if (strlen(SortMethod))
-    ProcessHigh = 0;
-  if (ProcessHigh)
-    Key = HighConverted(Key);
-  int KeyTag;
-  KeyTag = Key[0];
-  char *NewKey;
-  char *apointer;
-  int rover;
-  if (KeyTag == '&') {
-    while (strchr(Key,'&') == 0)
-      Key++;
-    ESCAPED_CHAR(Key,'&');
-  } else if (KeyTag == '+') {
-    while (strchr(Key,'+') == 0)
-      Key++;
-    ESCAPED_CHAR(Key,'+');
-  } else {
-    NewKey = safe_strdup(Key);
-    Key = NewKey;
-    ESCAPED_CHAR(Key,'&');
-    ESCAPED_CHAR(Key,'+');
-  }
-  my_concat (&Key,Key," "); /* so, "Word" comes for "Word Another Word" */
-  int EntryTag;
-  EntryTag = Entry[0] ;
-  if (EntryTag == '&') {
-    while (strchr(Entry,'&') == 0)
-      Entry++;
-    ESCAPED_CHAR(Entry,'&');
-  } else if (EntryTag == '+') {
-    while (strchr(Entry,'+') == 0)
-      Entry++;
-    ESCAPED_CHAR(Entry,'+');
-  } else if (KeyTag == '&') {
-    ESCAPED_CHAR(Entry,'&');
-  } else if (KeyTag == '+') {
-    ESCAPED_CHAR(Entry,'+');
+  struct registerkey *Keys = NULL;
+  char CacheKey[BUFSIZE];
+  int Cached = 0;
+  if (KeyCache != NULL &&
+      snprintf(CacheKey,BUFSIZE,"%d%d%d:%d:%s\001%s",ProcessHigh,ProcessIJ,ProcessQuotes,SortN,Key,Entry) < BUFSIZE) {
+    Keys = do_get_value(KeyCache,CacheKey);
+    if (Keys == NULL) {
+      Keys = RegisterKey(TeXUtil,Key,Entry);
+      do_set_value(KeyCache,CacheKey,Keys);
+    }
+    Cached = 1;
   } else {
-    ESCAPED_CHAR(Entry,'&');
-    ESCAPED_CHAR(Entry,'+');
-  }
-  if (!isalpha(Key[0]))
-    my_concat(&Key," ",Key);
-  STRIP_PRE_SPACE_AND_BRACES(Key);
-  if (*Entry == '{')
-    STRIP_PRE_SPACE_AND_BRACES(Entry);
-  if (ProcessIJ) {
-    ESCAPED_IJ(Key);
+    Keys = RegisterKey(TeXUtil,Key,Entry);
   }
-  char *LCKey = safe_strdup(Key);
-  LCKey = lc(LCKey);
   int RegStatus=0;
   /* from %RegStat */
   if (SecondTag == 'f') {
@@ -1460,22 +1588,40 @@ void HandleRegister (texutil TeXUtil, char *RestOfLine) {
     RegStatus = RegStat_s;
   }
   EXTEND_ARRAY(RegisterEntry,NOfEntries);
-  char *result = safe_malloc(BUFSIZE);
-  snprintf(result,BUFSIZE,
+  char line[BUFSIZE];
+  snprintf(line,BUFSIZE,
 	   "%s__%s__%s__%s__%s__%i__%6i__%s__%s__%s__%s",
-	   Class,LCKey,Key,Entry,TextHow,RegStatus,RealPage,Location,PageStr,PageHow,SeeToo);
-  result = safe_realloc(result,strlen(result)+1);
+	   Class,Keys->LCKey,Keys->Key,Keys->Entry,TextHow,RegStatus,RealPage,Location,PageStr,PageHow,SeeToo);
+  int length = strlen(line);
+  struct registerentry *result = arena_alloc(EntryArena,sizeof(struct registerentry));
+  result->SortKey       = FoldedKey(TeXUtil,line,length);
+  result->SortKeyLength = length;
+  result->Class         = Class;
+  result->Key           = arena_strdup(EntryArena,Keys->Key);
+  result->Entry         = arena_strdup(EntryArena,Keys->Entry);
+  result->TextHow       = TextHow;
+  result->Location      = Location;
+  result->Page          = PageStr;
+  result->PageHow       = PageHow;
+  result->SeeToo        = SeeToo;
+  result->RegStatus     = RegStatus;
+  result->RealPage      = RealPage;
   RegisterEntry[NOfEntries++] = result;
-  safe_free(Key);
+  if (!Cached)
+    safe_free(Keys);
 }
 
-char *How (char *TextHow,char *in){
-  char *HowJ=NULL;
-  my_concat3(&HowJ,TextHow,RegSep,in);
-  return HowJ;
+/* The perl version compares "TextHow::Entry" strings; comparing the two
+ * parts saves building them.  A |NULL| |PrevHow| matches nothing.
+ */
+static int SameHow (char *TextHow, char *Actual, char *PrevHow, char *PrevActual) {
+  return (PrevHow != NULL && STREQ(TextHow,PrevHow) && STREQ(Actual,PrevActual));
 }
 
 
+/* the arguments of \registerfrom, \registerto and \registerpage */
+#define PageReference "{%s}{%s,%s}{%s}{%s}{%d}\n"
+
 #define  FlushSavedLine() {				\
   if ((CollapseEntries)&&(strlen(SavedFrom) !=0 )) {    \
     if (strlen(SavedTo) != 0) {                         \
@@ -1492,7 +1638,6 @@ char *How (char *TextHow,char *in){
 void FlushRegisters (texutil TeXUtil) {
   int CollapseEntries=0; /*useless variable */
   fprintf (TUO, "%%\n%% %s / Registers\n%%\n",Program );
-  qsort(RegisterEntry,NOfEntries,sizeof(char *),my_strcasecmp);
   int NOfSaneEntries = 0 ;
   int NOfSanePages   = 0 ;
   char *LastPage     = "";
@@ -1502,6 +1647,9 @@ void FlushRegisters (texutil TeXUtil) {
   char *PreviousA      = "" ;
   char *PreviousB      = "" ;
   char *PreviousC      = "" ;
+  char *PrevHowA       = NULL ;
+  char *PrevHowB       = NULL ;
+  char *PrevHowC       = NULL ;
   char *ActualA        = "" ;
   char *ActualB        = "" ;
   char *ActualC        = "" ;
@@ -1510,27 +1658,31 @@ void FlushRegisters (texutil TeXUtil) {
   char *SavedEntry = "" ;
   int n;
   char *tempentry;
-  char *SavedLine = safe_malloc(BUFSIZE);
-  char *NextEntry = safe_malloc(BUFSIZE);
+  char *SavedLine = NULL;
+  char *NextEntry = NULL;
+  if (CollapseEntries) {
+    /* only collapsing needs the lines as strings */
+    SavedLine = safe_malloc(BUFSIZE);
+    NextEntry = safe_malloc(BUFSIZE);
+  }
   int Copied = 0;
   char TestAlfa = 0;
+  struct sortitem *Order = safe_malloc(sizeof(struct sortitem)*(NOfEntries+1));
+  for (n=0 ; n<NOfEntries ; n++)
+    MakeSortItem(&Order[n],RegisterEntry[n]->SortKey,RegisterEntry[n]->SortKeyLength,n);
+  SortItems(Order,NOfEntries);
   for (n=0 ; n<NOfEntries ; n++) {
-    tempentry = RegisterEntry[n];
-    char *Class         = next_word(&tempentry,JOIN);
-    char *LCKey         = next_word(&tempentry,JOIN);
-    LCKey = NULL; /* not used */
-    char *Key           = next_word(&tempentry,JOIN);
-    char *Entry         = next_word(&tempentry,JOIN);
-    char *TextHow       = next_word(&tempentry,JOIN);
-    int RegisterState   = atoi(next_word(&tempentry,JOIN));
-    char *RealPageStr   = next_word(&tempentry,JOIN);
-    char *Location      = next_word(&tempentry,JOIN);
-    char *Page          = next_word(&tempentry,JOIN);
-    char *PageHow       = next_word(&tempentry,JOIN);
-    char *SeeToo        = tempentry;
-    while (isspace(*RealPageStr))
-      RealPageStr++;
-    int RealPage = atoi (RealPageStr);
+    struct registerentry *entry = RegisterEntry[Order[n].index];
+    char *Class         = entry->Class;
+    char *Key           = entry->Key;
+    char *Entry         = entry->Entry;
+    char *TextHow       = entry->TextHow;
+    int RegisterState   = entry->RegStatus;
+    char *Location      = entry->Location;
+    char *Page          = entry->Page;
+    char *PageHow       = entry->PageHow;
+    char *SeeToo        = entry->SeeToo;
+    int RealPage        = entry->RealPage;
     TestAlfa = tolower(Key[0]);
     if (SortN){
       /*
@@ -1542,8 +1694,7 @@ void FlushRegisters (texutil TeXUtil) {
     }
     if (TestAlfa != Alfa || (!strcmp(AlfaClass,Class)==0)) {
       Alfa = TestAlfa ;
-      safe_free(AlfaClass);
-      AlfaClass = safe_strdup(Class);
+      AlfaClass = Class;
       if (Alfa != ' ')  {
 	FlushSavedLine();
 	fprintf (TUO, "\\registerentry{%s}{%c}\n", Class,Alfa);
@@ -1564,29 +1715,26 @@ void FlushRegisters (texutil TeXUtil) {
       ActualB = "";
       ActualC = "";
     }
-    char *HowJ = How(TextHow,ActualA);
-    if (STREQ(HowJ,PreviousA)) {
-      safe_free(HowJ);
+    if (SameHow(TextHow,ActualA,PrevHowA,PreviousA)) {
       ActualA = "" ;
     } else {
-      PreviousA = HowJ;
-      PreviousB = "" ;
-      PreviousC = "" ;
+      PrevHowA = TextHow;
+      PreviousA = ActualA;
+      PrevHowB = NULL ;
+      PrevHowC = NULL ;
     }
-    HowJ = How(TextHow,ActualB);
-    if (STREQ(HowJ,PreviousB)) {
+    if (SameHow(TextHow,ActualB,PrevHowB,PreviousB)) {
       ActualB = "" ;
-      safe_free(HowJ);
     } else {
-      PreviousB = HowJ ;
-      PreviousC = "" ;
+      PrevHowB = TextHow;
+      PreviousB = ActualB ;
+      PrevHowC = NULL ;
     }
-    HowJ = How(TextHow,ActualC);
-    if (STREQ(HowJ,PreviousC)) {
+    if (SameHow(TextHow,ActualC,PrevHowC,PreviousC)) {
       ActualC = "";
-      safe_free(HowJ);
     } else {
-      PreviousC = HowJ ;
+      PrevHowC = TextHow;
+      PreviousC = ActualC ;
     }
     Copied = 0 ;
     if (strlen(ActualA)) {
@@ -1612,16 +1760,16 @@ void FlushRegisters (texutil TeXUtil) {
       LastPage = Page ;
       LastRealPage = RealPage;
     } else if ((Copied) || ! ((STREQ(LastPage,Page)) && (LastRealPage == RealPage))) {
-      snprintf(NextEntry,BUFSIZE,"{%s}{%s}{%s}{%s}{%s,%s}",Class,PreviousA,PreviousB,PreviousC,PageHow,TextHow);
-      snprintf(SavedLine,BUFSIZE,"{%s}{%s,%s}{%s}{%s}{%d}\n",Class,PageHow,TextHow,Location,Page,RealPage);
       if (RegisterState == RegStat_f)  {
 	FlushSavedLine() ;
-	fprintf( TUO, "\\registerfrom%s",SavedLine);
+	fprintf (TUO, "\\registerfrom" PageReference,Class,PageHow,TextHow,Location,Page,RealPage);
       } else if (RegisterState == RegStat_t) {
 	FlushSavedLine() ;
-	fprintf (TUO, "\\registerto%s" , SavedLine);
+	fprintf (TUO, "\\registerto" PageReference,Class,PageHow,TextHow,Location,Page,RealPage);
       } else {
 	if (CollapseEntries) {
+	  snprintf(NextEntry,BUFSIZE,"{%s}{%s}{%s}{%s}{%s,%s}",Class,PreviousA,PreviousB,PreviousC,PageHow,TextHow);
+	  snprintf(SavedLine,BUFSIZE,PageReference,Class,PageHow,TextHow,Location,Page,RealPage);
 	  if (!STREQ(SavedEntry,NextEntry)) {
 	    SavedFrom = SavedLine;
 	  } else {
@@ -1629,20 +1777,20 @@ void FlushRegisters (texutil TeXUtil) {
 	  }
 	  SavedEntry = NextEntry;
 	} else {
-	  fprintf (TUO, "\\registerpage%s", SavedLine);
+	  fprintf (TUO, "\\registerpage" PageReference,Class,PageHow,TextHow,Location,Page,RealPage);
 	}
       }
       ++NOfSanePages ;
       LastPage = Page ;
       LastRealPage = RealPage ;
     }
-    safe_free(RegisterEntry[n]);
   }
-  safe_free(AlfaClass);
+  safe_free(Order);
   FlushSavedLine();
   safe_free(NextEntry);
   safe_free(SavedLine);
   safe_free(RegisterEntry);
+  RegisterEntry = NULL;
   fprintf(STDOUT,"%s %d -> %d %s %d %s\n",MS[ID_RegisterEntries],NOfEntries,
 	  NOfSaneEntries,MS[ID_Entries],NOfSanePages,MS[ID_References]);
   if (NOfBadEntries>0)
@@ -1672,46 +1820,45 @@ void HandleSynonym (texutil TeXUtil, char *RestOfLine)  {
     ++NOfBadSynonyms ;
   } else {
     EXTEND_ARRAY(SynonymEntry,NOfSynonyms);
-    char *entry = safe_malloc(BUFSIZE);
-    snprintf(entry,BUFSIZE,"%s__%s__%s__%s",Class,Key,Entry,Meaning);
-    entry = safe_realloc(entry,strlen(entry)+1);
+    char line[BUFSIZE];
+    snprintf(line,BUFSIZE,"%s__%s__%s__%s",Class,Key,Entry,Meaning);
+    int length = strlen(line);
+    struct synonymentry *entry = arena_alloc(EntryArena,sizeof(struct synonymentry));
+    entry->SortKey       = FoldedKey(TeXUtil,line,length);
+    entry->SortKeyLength = length;
+    entry->Class         = Class;
+    entry->Key           = Key;
+    entry->Entry         = Entry;
+    entry->Meaning       = Meaning;
     SynonymEntry[NOfSynonyms++] = entry;
   }
 }
 
 void FlushSynonyms (texutil TeXUtil) {
   fprintf(TUO, "%%\n%% %s / Synonyms\n%%\n", Program );
-  qsort(SynonymEntry,NOfSynonyms,sizeof(char *),my_strcasecmp);
   int NOfSaneSynonyms = 0 ;
   int n;
-  char *tmpentry;
-  char *ztmpentry;
-  char *Class;
-  char *Key;
-  char *Entry;
-  char *Meaning;
+  struct synonymentry *entry;
+  struct synonymentry *previous = NULL;
+  struct sortitem *Order = safe_malloc(sizeof(struct sortitem)*(NOfSynonyms+1));
+  for (n=0; n<NOfSynonyms; n++)
+    MakeSortItem(&Order[n],SynonymEntry[n]->SortKey,SynonymEntry[n]->SortKeyLength,n);
+  SortItems(Order,NOfSynonyms);
   for (n=0; n<NOfSynonyms; n++) {
-    if ((n==0)||(!STREQ(SynonymEntry[n],SynonymEntry[n-1]))) {
-      tmpentry = safe_strdup(SynonymEntry[n]);
-      ztmpentry = tmpentry;
-      Class="";
-      Key="";
-      Entry="";
-      Meaning="";
-      Class = next_word(&tmpentry,JOIN);
-      Key   = next_word(&tmpentry,JOIN);
-      Entry = next_word(&tmpentry,JOIN);
-      Meaning = tmpentry;
+    entry = SynonymEntry[Order[n].index];
+    /* exact duplicates are written once */
+    if ((previous == NULL) ||
+	!(STREQ(entry->Class,previous->Class) && STREQ(entry->Key,previous->Key) &&
+	  STREQ(entry->Entry,previous->Entry) && STREQ(entry->Meaning,previous->Meaning))) {
       ++NOfSaneSynonyms ;
-      fprintf (TUO, "\\synonymentry{%s}{%s}{%s}{%s}\n", Class,Key,Entry,Meaning);
-      safe_free (ztmpentry);
-      if (n!=0)
-	safe_free (SynonymEntry[n-1]);
+      fprintf (TUO, "\\synonymentry{%s}{%s}{%s}{%s}\n",
+	       entry->Class,entry->Key,entry->Entry,entry->Meaning);
     }
+    previous = entry;
   }
-  if(NOfSynonyms)
-    safe_free(SynonymEntry[NOfSynonyms]);
+  safe_free(Order);
   safe_free(SynonymEntry);
+  SynonymEntry = NULL;
   fprintf(STDOUT,"%s %d -> %d %s\n",
 	  MS[ID_SynonymEntries],NOfSynonyms,NOfSaneSynonyms,MS[ID_Entries]);
   if (NOfBadSynonyms>0)
@@ -1731,14 +1878,14 @@ void HandleFile (texutil TeXUtil,char *RestOfLine) {
   *kick = 0;
   int test = -1;
   int i;
-  for (i=0;i<=NOfFiles;i++) {
+  for (i=0;i<NOfFiles;i++) {
     if(STREQ(Files[i],RestOfLine))
       test = i;
   }
   if (test>=0) {
     File_opens[test]++;
   } else {
-    if (Files_size < NOfFiles) {
+    if (Files_size <= NOfFiles) {
       Files = safe_realloc(Files,sizeof(char*)*(Files_size+Files_add));
       File_opens = safe_realloc(File_opens,sizeof(int)*(Files_size+Files_add));
       Files_size = Files_size+Files_add;
@@ -1767,6 +1914,8 @@ void FlushFiles (texutil TeXUtil) {
   }
   safe_free(File_opens);
   safe_free(Files);
+  File_opens = NULL;
+  Files = NULL;
 }
 
 void FlushData (texutil TeXUtil)  {
@@ -1790,31 +1939,33 @@ void FlushData (texutil TeXUtil)  {
 void MergerHandleReferences (texutil TeXUtil,int ValidOutput,string *ARGV) {
   char *Suffix ;
   char *TempInputFile;
+  int NOfTUIs = 0;
+  int i;
+  /* the entries point into the files, so all stay mapped until the flush */
+  struct textfile *TUIs;
+  while (ARGV[NOfTUIs])
+    NOfTUIs++;
+  TUIs = safe_malloc(sizeof(struct textfile)*(NOfTUIs+1));
   unlink("texutil.tuo");
   fprintf(STDOUT,"%s %s\n",MS[ID_OutputFile],"texutil.tuo" ) ;
   safe_fopen (TUO,"texutil.tuo","w") ;
-  while (*ARGV) {
-    TempInputFile = *ARGV++;
+  for (i=0; i<NOfTUIs; i++) {
+    TempInputFile = ARGV[i];
     InputFile = next_word(&TempInputFile,".");
     Suffix = TempInputFile;
     char *tuifile = NULL;
     my_concat(&tuifile,InputFile,".tui");
-    FILE *TUI;
-    safe_fopen(TUI,tuifile,"r");
-    safe_free(tuifile);
-    if(!TUI) {
+    if(!map_textfile(&TUIs[i],tuifile)) {
       fprintf(STDOUT,"%s %s %s\n",MS[ID_Error], MS[ID_EmptyInputFile], InputFile) ;
     } else {
       fprintf(STDOUT,"%s %s.tui\n", MS[ID_InputFile], InputFile) ;
-      char *SomeLine = safe_malloc(BUFSIZE);
-      while (readline(TUI,&SomeLine)) {
-	SomeLine = chomp (SomeLine);
+      char *SomeLine;
+      while ((SomeLine = mapped_readline(&TUIs[i])) != NULL) {
 	if (SomeLine[0] == 'r' && SomeLine[1] == ' ')
 	  HandleRegister(TeXUtil,(SomeLine+2));
       }
-      safe_free(SomeLine);
-      safe_fclose(TUI);
     }
+    safe_free(tuifile);
   }
   if (ValidOutput) {
     FlushRegisters(TeXUtil) ;
@@ -1824,6 +1975,10 @@ void MergerHandleReferences (texutil TeXUtil,int ValidOutput,string *ARGV) {
     unlink ("texutil.tuo");
     fprintf(STDOUT,"%s %s\n",MS[ID_Remark],MS[ID_NoOutputFile]);
   }
+  arena_free(EntryArena);
+  for (i=0; i<NOfTUIs; i++)
+    unmap_textfile(&TUIs[i]);
+  safe_free(TUIs);
 }
 
 void NormalHandleReferences (texutil TeXUtil, int ValidOutput) {
@@ -1832,9 +1987,9 @@ void NormalHandleReferences (texutil TeXUtil, int ValidOutput) {
   } else {
     char *tuifile = NULL;
     my_concat(&tuifile,InputFile,".tui");
-    FILE *TUI;
-    safe_fopen(TUI,tuifile,"r");
-    if (!TUI) {
+    /* the entries point into the file, so it stays mapped until the flush */
+    struct textfile TUI;
+    if (!map_textfile(&TUI,tuifile)) {
       safe_free(tuifile);
       fprintf(STDOUT,"%s %s %s\n",MS[ID_Error], MS[ID_EmptyInputFile], InputFile);
     } else {
@@ -1849,16 +2004,16 @@ void NormalHandleReferences (texutil TeXUtil, int ValidOutput) {
       fprintf(STDOUT,"%s %s\n",MS[ID_OutputFile], tuofile);
       safe_fopen (TUO,tuofile,"w");
       if (!TUO) {
+	unmap_textfile(&TUI);
 	safe_free(tmpfile);
 	safe_free(tuofile);
 	return;
       }
       fprintf (TUO,"%%\n%% %s / Commands\n%%\n",Program);
-      char *SomeLine = safe_malloc(BUFSIZE);
+      char *SomeLine;
       char *RestOfLine=NULL;
       char FirstTag;
-      while (readline(TUI,&SomeLine)) {
-	SomeLine = chomp (SomeLine);
+      while ((SomeLine = mapped_readline(&TUI)) != NULL) {
 	FirstTag = SomeLine[0];
 	if (strlen(SomeLine) > 2 && SomeLine[1] == ' ') {
 	  RestOfLine = SomeLine+2;
@@ -1887,7 +2042,6 @@ void NormalHandleReferences (texutil TeXUtil, int ValidOutput) {
 	}
       }
     EXIT:
-      safe_free(SomeLine);
       if (ValidOutput) {
 	FlushCommands(TeXUtil) ;
 	FlushKeys(TeXUtil) ;
@@ -1904,6 +2058,8 @@ void NormalHandleReferences (texutil TeXUtil, int ValidOutput) {
 	rename (tmpfile, tuofile);
 	fprintf(STDOUT,"%s %s\n", MS[ID_Remark], MS[ID_NoOutputFile]);
       }
+      arena_free(EntryArena);
+      unmap_textfile(&TUI);
       safe_free(tuofile);
       safe_free(tmpfile);
     }
@@ -1927,8 +2083,10 @@ void HandleReferences (texutil TeXUtil, int ARGC,string *ARGV) {
       fprintf(STDOUT,"%s %s\n",MS[ID_Option],MS[ID_ProcessingQuotes]);
     InitializeKeys(TeXUtil, ARGV) ;
     ExtraPrograms = safe_malloc(sizeof(char*)*ExtraPrograms_size);
-    RegisterEntry = safe_malloc(sizeof(char *)*RegisterEntry_size);
-    SynonymEntry  = safe_malloc(sizeof(char *)*SynonymEntry_size);
+    RegisterEntry = safe_malloc(sizeof(*RegisterEntry)*RegisterEntry_size);
+    SynonymEntry  = safe_malloc(sizeof(*SynonymEntry)*SynonymEntry_size);
+    EntryArena    = safe_malloc(sizeof(struct arena));
+    EntryArena->block = NULL;
     Files         = safe_malloc(sizeof(char *)*Files_size);
     File_opens    = safe_malloc(sizeof(int)*Files_size);
     int ValidOutput = 1 ;
@@ -1937,6 +2095,8 @@ void HandleReferences (texutil TeXUtil, int ARGC,string *ARGV) {
     } else {
       NormalHandleReferences (TeXUtil, ValidOutput);
     }
+    safe_free(EntryArena);
+    EntryArena = NULL;
 }
 
 
@@ -3597,9 +3757,9 @@ void GenerateSciteApi (texutil TeXUtil, char *filename) {
 		my_concat(&xcommand,"start",cmdname);
 		Collection[iNOfCommands++] = xcommand;
 		EXTEND_ARRAY(Collection,iNOfCommands);
+		xcommand = NULL;
 		my_concat(&xcommand,"start",cmdname);
 		Collection[iNOfCommands++] = xcommand;
-		safe_free(xcommand);
 	      }
 	    }
 	  }
@@ -3703,15 +3863,44 @@ int texutil_main (texutil TeXUtil, int ARGC,  string *ARGV) {
 
 
 
-texutil texutil_new (void) {
-  static const struct texutilstruct dummy = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+static const struct texutilstruct texutil_defaults = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
 					     "","","",NULL,0.0,"en",NULL,"texutil.log",NULL,NULL,0,
-					     NULL,10,10,0,NULL,100,100,NULL,100,100,NULL,NULL,10,10,0,
+					     NULL,10,10,0,NULL,100,100,NULL,100,100,NULL,NULL,NULL,NULL,10,10,0,
 					     NULL,100,100,0,0,0,0,0,0,0,0,0,0,{NULL}};
 
+texutil texutil_new (void) {
   texutil TeXUtil = malloc (sizeof(struct texutilstruct));
-  memcpy(TeXUtil,&dummy,sizeof(struct texutilstruct));
+  memcpy(TeXUtil,&texutil_defaults,sizeof(struct texutilstruct));
   STDOUT  = stdout;
   return TeXUtil;
 }
 
+/* Readies a texutil for another run: everything is back to the defaults
+ * except the register key cache.  A run that stopped before its Flush
+ * routines still owns its arrays, so those are released first.
+ */
+void texutil_reset (texutil TeXUtil) {
+  struct hash_table *cache = KeyCache;
+  int i;
+  if (EntryArena != NULL) {
+    arena_free(EntryArena);
+    safe_free(EntryArena);
+  }
+  safe_free(RegisterEntry);
+  safe_free(SynonymEntry);
+  if (Files != NULL) {
+    for (i=0; i<NOfFiles; i++)
+      safe_free(Files[i]);
+  }
+  safe_free(Files);
+  safe_free(File_opens);
+  if (ExtraPrograms != NULL) {
+    for (i=0; i<NOfExtraPrograms; i++)
+      safe_free(ExtraPrograms[i]);
+  }
+  safe_free(ExtraPrograms);
+  memcpy(TeXUtil,&texutil_defaults,sizeof(struct texutilstruct));
+  STDOUT   = stdout;
+  KeyCache = cache;
+}
+
@@ -34,6 +34,25 @@ ID_PlugInInit, ID_PlugInReport, ID_HelpInfo, size_of_ID_list,
 } Message_ID;
 
 
+/* A register or synonym entry from the .tui file, split into its fields
+ * once.  |SortKey| is the case folded line the perl version sorts on.
+ * Entries live in |EntryArena|; fields that need no rewriting point into
+ * the mapped .tui file itself.
+ */
+struct registerentry {
+  char *Class, *Key, *Entry, *TextHow, *Location, *Page, *PageHow, *SeeToo;
+  int RegStatus;
+  int RealPage;
+  unsigned char *SortKey;
+  int SortKeyLength;
+};
+
+struct synonymentry {
+  char *Class, *Key, *Entry, *Meaning;
+  unsigned char *SortKey;
+  int SortKeyLength;
+};
+
 /*  These are the option variables */
 struct texutilstruct {
   int UnknownOptions_field      ;
@@ -77,12 +96,14 @@ struct texutilstruct {
   int ExtraPrograms_size_field  ;
   int ExtraPrograms_add_field   ;
   int NOfExtraPrograms_field    ;
-  string *RegisterEntry_field   ;
+  struct registerentry **RegisterEntry_field;
   int RegisterEntry_size_field  ;
   int RegisterEntry_add_field   ;
-  string *SynonymEntry_field    ;
+  struct synonymentry **SynonymEntry_field;
   int SynonymEntry_size_field   ;
   int SynonymEntry_add_field    ;
+  struct arena *EntryArena_field;
+  struct hash_table *KeyCache_field; /* see HandleRegister */
   string *Files_field           ;
   int *File_opens_field         ;
   int Files_size_field          ;
@@ -108,3 +129,4 @@ typedef struct texutilstruct* texutil;
 
 int     texutil_main (texutil TeXUtil, int ARGC,  string *ARGV);
 texutil texutil_new (void);
+void    texutil_reset (texutil TeXUtil);
@@ -8,11 +8,6 @@
 typedef struct option getoptstruct;
 
 
-static struct texutilstruct the_texutil = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                                           "","","",NULL,0.0,"en",NULL,"texutil.log",NULL,NULL,0,
-										   NULL,10,10,0,NULL,100,100,NULL,100,100,NULL,NULL,10,10,0,
-                                           NULL,100,100,0,0,0,0,0,0,0,0,0,0,{NULL}};
-
 #define STREQ(s1, s2) ((s1) && (strcmp (s1, s2) == 0))
 #define ARGUMENT_IS(a) STREQ (long_options[option_index].name, a)
 
@@ -78,8 +73,7 @@ int parse_options(texutil TeXUtil,int argc,  string * argv) {
 
 
 int main(int ac,  string *av) {
-  texutil TeXUtil = &the_texutil;
-  TeXUtil->STDOUT_field = stdout;
+  texutil TeXUtil = texutil_new();
   int optind;
   optind = parse_options (TeXUtil, ac,av);
   int ARGC = (ac-optind);